@@ -0,0 +1,283 @@
+/* bayer.c
+**
+** RGGB -> RGB 2x2 downscale kernels
+** scalar reference, SSE2, AVX2 and NEON
+** with runtime cpu dispatch
+**
+** License: GPL
+**
+*/
+#include "bayer.h"
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define BAYER_X86 1
+#include <immintrin.h>
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define BAYER_NEON 1
+#include <arm_neon.h>
+#endif
+
+void bayer_downscale_row_scalar(const u8 *row0, const u8 *row1, u8 *rgb, int width)
+{
+  int j;
+
+  for(j = 0; j < width; j += 2)
+  {
+    *rgb++ = row0[j];
+    *rgb++ = (row0[j + 1] + row1[j]) / 2;
+    *rgb++ = row1[j + 1];
+  }
+}
+
+/* factor x factor downscale (factor 4 or 8 for preview) of
+** factor contiguous RGGB rows: each RGB pixel is the mean
+** of the R, G and B samples of its block.
+** width/factor RGB pixels are written
+*/
+void bayer_bin_rows(const u8 *rows, int width, int factor, u8 *rgb)
+{
+  const u8 *row0, *row1;
+  int i, j, x, r, g, b;
+  int n = factor * factor / 4; /* samples of R or B in a block */
+
+  for(x = 0; x + factor <= width; x += factor)
+  {
+    r = g = b = 0;
+    for(j = 0; j < factor; j += 2)
+    {
+      row0 = rows + j * width + x;
+      row1 = row0 + width;
+      for(i = 0; i < factor; i += 2)
+      {
+        r += row0[i];
+        g += row0[i + 1] + row1[i];
+        b += row1[i + 1];
+      }
+    }
+    *rgb++ = r / n;
+    *rgb++ = g / (2 * n);
+    *rgb++ = b / n;
+  }
+}
+
+static int bayer_always(void)
+{
+  return 1;
+}
+
+#if BAYER_X86
+/* store 16 RGB pixels (48 bytes) from planar r, g, b vectors.
+** Pixels are interleaved as RGB0, each 64 bit lane squeezed
+** to 6 bytes and stored with 8 byte stores which overwrite
+** 2 bytes past the end. Caller must have room for them.
+*/
+__attribute__((target("sse2")))
+static inline void bayer_store_rgb_sse2(u8 *out, __m128i r, __m128i g, __m128i b)
+{
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i m_lo = _mm_set_epi32(0, 0x00ffffff, 0, 0x00ffffff);
+  const __m128i m_hi = _mm_set_epi32(0x0000ffff, 0xff000000, 0x0000ffff, 0xff000000);
+  __m128i rg_lo = _mm_unpacklo_epi8(r, g), rg_hi = _mm_unpackhi_epi8(r, g);
+  __m128i b0_lo = _mm_unpacklo_epi8(b, zero), b0_hi = _mm_unpackhi_epi8(b, zero);
+  __m128i p[4];
+  int i;
+
+  p[0] = _mm_unpacklo_epi16(rg_lo, b0_lo);
+  p[1] = _mm_unpackhi_epi16(rg_lo, b0_lo);
+  p[2] = _mm_unpacklo_epi16(rg_hi, b0_hi);
+  p[3] = _mm_unpackhi_epi16(rg_hi, b0_hi);
+  for(i = 0; i < 4; i++, out += 12)
+  {
+    __m128i v = _mm_or_si128(_mm_and_si128(p[i], m_lo),
+                             _mm_and_si128(_mm_srli_epi64(p[i], 8), m_hi));
+    _mm_storel_epi64((__m128i *) out, v);
+    _mm_storel_epi64((__m128i *) (out + 6), _mm_srli_si128(v, 8));
+  }
+}
+
+/* (a+b)/2 rounded down, pavgb alone rounds up */
+__attribute__((target("sse2")))
+static inline __m128i bayer_mean_sse2(__m128i a, __m128i b)
+{
+  return _mm_sub_epi8(_mm_avg_epu8(a, b),
+                      _mm_and_si128(_mm_xor_si128(a, b), _mm_set1_epi8(1)));
+}
+
+__attribute__((target("sse2")))
+static void bayer_downscale_row_sse2(const u8 *row0, const u8 *row1, u8 *rgb, int width)
+{
+  const __m128i lo = _mm_set1_epi16(0x00ff);
+  int x, n = width / 2;
+
+  /* strictly less: last block is left to scalar code
+  ** so the overlapping stores stay inside the row */
+  for(x = 0; x + 16 < n; x += 16)
+  {
+    __m128i a0 = _mm_loadu_si128((const __m128i *) (row0 + 2*x));
+    __m128i a1 = _mm_loadu_si128((const __m128i *) (row0 + 2*x + 16));
+    __m128i b0 = _mm_loadu_si128((const __m128i *) (row1 + 2*x));
+    __m128i b1 = _mm_loadu_si128((const __m128i *) (row1 + 2*x + 16));
+    __m128i r  = _mm_packus_epi16(_mm_and_si128(a0, lo), _mm_and_si128(a1, lo));
+    __m128i g1 = _mm_packus_epi16(_mm_srli_epi16(a0, 8), _mm_srli_epi16(a1, 8));
+    __m128i g2 = _mm_packus_epi16(_mm_and_si128(b0, lo), _mm_and_si128(b1, lo));
+    __m128i b  = _mm_packus_epi16(_mm_srli_epi16(b0, 8), _mm_srli_epi16(b1, 8));
+
+    bayer_store_rgb_sse2(rgb + 3*x, r, bayer_mean_sse2(g1, g2), b);
+  }
+  bayer_downscale_row_scalar(row0 + 2*x, row1 + 2*x, rgb + 3*x, width - 2*x);
+}
+
+__attribute__((target("avx2")))
+static void bayer_downscale_row_avx2(const u8 *row0, const u8 *row1, u8 *rgb, int width)
+{
+  const __m256i lo = _mm256_set1_epi16(0x00ff);
+  const __m256i one = _mm256_set1_epi8(1);
+  int x, n = width / 2;
+
+  for(x = 0; x + 32 < n; x += 32)
+  {
+    __m256i a0 = _mm256_loadu_si256((const __m256i *) (row0 + 2*x));
+    __m256i a1 = _mm256_loadu_si256((const __m256i *) (row0 + 2*x + 32));
+    __m256i b0 = _mm256_loadu_si256((const __m256i *) (row1 + 2*x));
+    __m256i b1 = _mm256_loadu_si256((const __m256i *) (row1 + 2*x + 32));
+    /* packus works within 128 bit lanes, permute restores pixel order */
+    __m256i r  = _mm256_permute4x64_epi64(
+      _mm256_packus_epi16(_mm256_and_si256(a0, lo), _mm256_and_si256(a1, lo)), 0xd8);
+    __m256i g1 = _mm256_permute4x64_epi64(
+      _mm256_packus_epi16(_mm256_srli_epi16(a0, 8), _mm256_srli_epi16(a1, 8)), 0xd8);
+    __m256i g2 = _mm256_permute4x64_epi64(
+      _mm256_packus_epi16(_mm256_and_si256(b0, lo), _mm256_and_si256(b1, lo)), 0xd8);
+    __m256i b  = _mm256_permute4x64_epi64(
+      _mm256_packus_epi16(_mm256_srli_epi16(b0, 8), _mm256_srli_epi16(b1, 8)), 0xd8);
+    __m256i g  = _mm256_sub_epi8(_mm256_avg_epu8(g1, g2),
+                   _mm256_and_si256(_mm256_xor_si256(g1, g2), one));
+
+    bayer_store_rgb_sse2(rgb + 3*x,
+      _mm256_castsi256_si128(r), _mm256_castsi256_si128(g), _mm256_castsi256_si128(b));
+    bayer_store_rgb_sse2(rgb + 3*x + 48,
+      _mm256_extracti128_si256(r, 1), _mm256_extracti128_si256(g, 1), _mm256_extracti128_si256(b, 1));
+  }
+  bayer_downscale_row_scalar(row0 + 2*x, row1 + 2*x, rgb + 3*x, width - 2*x);
+}
+
+static int bayer_have_sse2(void)
+{
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("sse2");
+}
+
+static int bayer_have_avx2(void)
+{
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2");
+}
+#endif
+
+#if BAYER_NEON
+static void bayer_downscale_row_neon(const u8 *row0, const u8 *row1, u8 *rgb, int width)
+{
+  int x, n = width / 2;
+
+  for(x = 0; x + 16 <= n; x += 16)
+  {
+    uint8x16x2_t rg = vld2q_u8(row0 + 2*x); /* val[0]=R val[1]=G1 */
+    uint8x16x2_t gb = vld2q_u8(row1 + 2*x); /* val[0]=G2 val[1]=B */
+    uint8x16x3_t out;
+
+    out.val[0] = rg.val[0];
+    out.val[1] = vhaddq_u8(rg.val[1], gb.val[0]); /* truncating halving add */
+    out.val[2] = gb.val[1];
+    vst3q_u8(rgb + 3*x, out);
+  }
+  bayer_downscale_row_scalar(row0 + 2*x, row1 + 2*x, rgb + 3*x, width - 2*x);
+}
+#endif
+
+/* slowest first, dispatch picks the last supported one */
+struct bayer_kernel bayer_kernels[] = {
+  { "scalar", bayer_downscale_row_scalar, bayer_always },
+#if BAYER_X86
+  { "sse2",   bayer_downscale_row_sse2,   bayer_have_sse2 },
+  { "avx2",   bayer_downscale_row_avx2,   bayer_have_avx2 },
+#endif
+#if BAYER_NEON
+  { "neon",   bayer_downscale_row_neon,   bayer_always },
+#endif
+  { NULL, NULL, NULL },
+};
+
+bayer_row_kernel bayer_downscale_row = bayer_downscale_row_scalar;
+
+/* fastest kernel is picked when the program or library
+** is loaded, before any thread can convert rows
+*/
+__attribute__((constructor))
+static void bayer_init(void)
+{
+  bayer_select(NULL);
+}
+
+/* select kernel by name, or the fastest supported one if name is NULL.
+** Not while other threads convert rows (bench only).
+** returns selected kernel or NULL if name is unknown or unsupported
+*/
+struct bayer_kernel *bayer_select(char *name)
+{
+  struct bayer_kernel *k, *best = NULL;
+
+  for(k = bayer_kernels; k->name; k++)
+  {
+    if(!k->supported())
+      continue;
+    if(name == NULL || strcmp(name, k->name) == 0)
+      best = k;
+  }
+  if(best)
+    bayer_downscale_row = best->downscale;
+  return best;
+}
+
+/* downscale all complete row pairs from circular buffer
+** of BAYER_CIRCULAR bytes. A row pair that wraps around
+** the end of the buffer is first copied to linear memory.
+** stops before a row pair that wouldn't fit into rgb_max.
+** returns last bayer_start that was left unprocessed
+*/
+int bayer_circular_downscale(
+              u8 *bayer_array,
+              int bayer_width, /* number of columns in a row of the bayer array */
+              int *bayer_start, /* modified to the next start */
+              int bayer_stop, /* end of read bytes */
+              u8 *rgb_array,
+              int rgb_max,
+              int *rgb_len)
+{
+  int i, irgb, pos, part;
+  int bayer_last;
+  u8 pair[2*BAYER_CIRCULAR/8];
+  u8 *row;
+
+  /* even number of complete bayer lines */
+  bayer_last = *bayer_start + (bayer_stop - *bayer_start) - ((bayer_stop - *bayer_start) % (2*bayer_width));
+  irgb = 0;
+  for(i = *bayer_start; i < bayer_last && irgb + 3*bayer_width/2 <= rgb_max; i += 2*bayer_width)
+  {
+    pos = (unsigned int) i % BAYER_CIRCULAR;
+    row = bayer_array + pos;
+    if(pos + 2*bayer_width > BAYER_CIRCULAR)
+    {
+      part = BAYER_CIRCULAR - pos;
+      memcpy(pair, row, part);
+      memcpy(pair + part, bayer_array, 2*bayer_width - part);
+      row = pair;
+    }
+    bayer_downscale_row(row, row + bayer_width, rgb_array + irgb, bayer_width);
+    irgb += 3*bayer_width/2;
+  }
+
+  *bayer_start = i;
+  *rgb_len = irgb;
+  return i;
+}
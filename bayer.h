@@ -0,0 +1,41 @@
+#ifndef BAYER_H
+#define BAYER_H
+#include "binarytype.h"
+
+#define BAYER_CIRCULAR 32768
+
+/* 2x2 downscale of one RGGB row pair into packed RGB
+**
+**   row0: R G R G ...
+**   row1: G B G B ...  -->  RGB RGB ...   G=(G1+G2)/2
+**
+** width is number of bayer pixels in a row (even),
+** width/2 RGB pixels are written
+*/
+typedef void (*bayer_row_kernel)(const u8 *row0, const u8 *row1, u8 *rgb, int width);
+
+struct bayer_kernel {
+  char *name;
+  bayer_row_kernel downscale;
+  int (*supported)(void); /* runtime cpu check */
+};
+
+/* all kernels compiled in, NULL terminated, scalar first */
+extern struct bayer_kernel bayer_kernels[];
+/* fastest kernel this cpu supports, chosen at load time */
+extern bayer_row_kernel bayer_downscale_row;
+
+void bayer_downscale_row_scalar(const u8 *row0, const u8 *row1, u8 *rgb, int width);
+void bayer_bin_rows(const u8 *rows, int width, int factor, u8 *rgb);
+struct bayer_kernel *bayer_select(char *name);
+
+int bayer_circular_downscale(
+              u8 *bayer_array,
+              int bayer_width,
+              int *bayer_start,
+              int bayer_stop,
+              u8 *rgb_array,
+              int rgb_max,
+              int *rgb_len);
+
+#endif
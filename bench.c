@@ -0,0 +1,280 @@
+/* bench.c
+**
+** Throughput benchmark of the processing path.
+** Synthetic RGGB frames go through simulation mode
+** dcm300_get_image() -> dcm300_session_capture() and
+** through the old SANE bayer_circular_downscale().
+** First every SIMD row kernel is checked against the
+** scalar one
+**
+** License: GPL
+**
+*/
+#include "dcm300.h"
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <time.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+
+#define BENCH_SECONDS 0.3 /* minimum time of one measurement */
+
+struct bench_geometry {
+  int w, h;
+} bench_geometry[] = {
+  {  128,  128 },
+  {  800,  600 },
+  { 1024,  768 },
+  { 2048, 1536 },
+  { 0, 0 },
+};
+
+struct bench_mode {
+  char *name;
+  int raw, demosaic, bin;
+} bench_mode[] = {
+  { "raw",      1, DEMOSAIC_BIN,      2 },
+  { "bin",      0, DEMOSAIC_BIN,      2 },
+  { "bin4",     0, DEMOSAIC_BIN,      4 },
+  { "bin8",     0, DEMOSAIC_BIN,      8 },
+  { "bilinear", 0, DEMOSAIC_BILINEAR, 2 },
+  { "mhc",      0, DEMOSAIC_MHC,      2 },
+  { NULL, 0, 0, 0 },
+};
+
+static double bench_seconds(void)
+{
+  struct timespec t;
+
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+/* RGGB pattern with some texture, same as a stream from the camera:
+** 64 byte header, image, 256 byte footer
+*/
+static u8 *bench_frame(int w, int h)
+{
+  u8 *frame;
+  int x, y;
+
+  frame = calloc(64 + w * h + 256, 1);
+  if(frame == NULL)
+    return NULL;
+  for(y = 0; y < h; y++)
+    for(x = 0; x < w; x++)
+      frame[64 + y * w + x] = (x * 7 + y * 13 + (x * y) % 31) & 255;
+  return frame;
+}
+
+static char *bench_write_frame(u8 *frame, int w, int h)
+{
+  static char name[64];
+  int fd;
+
+  snprintf(name, sizeof(name), "/tmp/dcm300-bench-%dx%d.raw", w, h);
+  fd = open(name, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if(fd < 0 || write(fd, frame, 64 + w * h + 256) != 64 + w * h + 256)
+  {
+    perror(name);
+    return NULL;
+  }
+  close(fd);
+  return name;
+}
+
+static void bench_report(char *mode, char *kernel, int w, int h,
+                         int frames, double seconds, double bytes)
+{
+  double pixels = (double) w * h * frames;
+
+  printf("%-8s %-6s %4dx%-4d %6d %10.1f %8.2f %10.1f\n",
+    mode, kernel, w, h, frames,
+    pixels / seconds * 1e-6, seconds * 1e9 / pixels, bytes / seconds * 1e-6);
+}
+
+/* same processing path as simulation mode.
+** A mode that fails is reported as such, not timed
+*/
+static int bench_pipeline(char *raw, struct bench_mode *mode, int w, int h, char *kernel)
+{
+  struct dcm300 bench[1];
+  struct stat st;
+  char out[] = "/tmp/dcm300-bench-out.XXXXXX";
+  double t0, t;
+  double bytes = 0;
+  int frames = 0, failed = 0;
+
+  memset(bench, 0, sizeof(*bench));
+  bench->name = raw;
+  bench->simulation = 1;
+  bench->usbfs = -1;
+  bench->bulk = MAXBULK;
+  bench->ring_size = BAYER_CIRCULAR;
+  bench->w = w;
+  bench->h = h;
+  bench->raw = mode->raw;
+  bench->demosaic = mode->demosaic;
+  bench->bin = mode->bin;
+  bench->threads = 1;
+  /* measure processing only, no progress */
+  bench->quiet = 1;
+  bench->output = mkstemp(out);
+  if(bench->output < 0)
+    return -1;
+  unlink(out);
+  if(dcm300_open(bench) < 0)
+  {
+    printf("%-8s %-6s %4dx%-4d can't open %s\n", mode->name, kernel, w, h, raw);
+    close(bench->output);
+    return -1;
+  }
+
+  /* untimed first frame warms up the session, the
+  ** timed ones follow it well within DCM300_WARM_MS
+  */
+  if(dcm300_get_image(bench) || bench->output_error)
+    failed = 1;
+  t0 = bench_seconds();
+  while(!failed)
+  {
+    if(ftruncate(bench->output, 0) || lseek(bench->output, 0, SEEK_SET) < 0
+    || dcm300_get_image(bench) || bench->output_error || fstat(bench->output, &st))
+    {
+      failed = 1;
+      break;
+    }
+    bytes += st.st_size;
+    frames++;
+    t = bench_seconds() - t0;
+    if(t >= BENCH_SECONDS)
+      break;
+  }
+
+  dcm300_close(bench);
+  close(bench->output);
+  if(failed)
+  {
+    printf("%-8s %-6s %4dx%-4d failed after %d frames\n", mode->name, kernel, w, h, frames);
+    return -1;
+  }
+  bench_report(mode->name, kernel, w, h, frames, t, bytes);
+  return 0;
+}
+
+/* SANE backend loop: 16K bulks into 32K circular buffer */
+static int bench_sane(u8 *frame, int w, int h, char *kernel)
+{
+  static u8 replybuf[BAYER_CIRCULAR];
+  static u8 rgb[3*BAYER_CIRCULAR/2];
+  int image_len = w * h;
+  int bytes_read, bulk_len, part, bayer_from, rgb_len;
+  double t0, t, bytes = 0;
+  int frames = 0;
+
+  t0 = bench_seconds();
+  do
+  {
+    bayer_from = 0;
+    for(bytes_read = 0; bytes_read < image_len; bytes_read += bulk_len)
+    {
+      bulk_len = image_len - bytes_read > MAXBULK ? MAXBULK : image_len - bytes_read;
+      part = BAYER_CIRCULAR - bytes_read % BAYER_CIRCULAR;
+      if(part > bulk_len)
+        part = bulk_len;
+      memcpy(replybuf + bytes_read % BAYER_CIRCULAR, frame + 64 + bytes_read, part);
+      memcpy(replybuf, frame + 64 + bytes_read + part, bulk_len - part);
+      bayer_circular_downscale(replybuf, w, &bayer_from, bytes_read + bulk_len, rgb, sizeof(rgb), &rgb_len);
+      bytes += rgb_len;
+    }
+    frames++;
+    t = bench_seconds() - t0;
+  } while(t < BENCH_SECONDS);
+
+  bench_report("sane", kernel, w, h, frames, t, bytes);
+  return 0;
+}
+
+/* SIMD kernels must give the scalar result byte for byte
+** at every row width, including the tails left to scalar
+** code, from unaligned rows, and write nothing past the
+** width/2 RGB pixels
+*/
+static int bench_check_kernels(void)
+{
+  static u8 row0[DCM300_WIDTH + 1], row1[DCM300_WIDTH + 1];
+  static u8 want[3*DCM300_WIDTH/2 + 16], got[3*DCM300_WIDTH/2 + 16];
+  struct bayer_kernel *k;
+  int i, width, offset, bad, failed = 0;
+
+  srand(1);
+  for(i = 0; i <= DCM300_WIDTH; i++)
+  {
+    row0[i] = rand();
+    row1[i] = rand();
+  }
+  for(k = bayer_kernels + 1; k->name; k++)
+  {
+    if(!k->supported())
+      continue;
+    bad = 0;
+    for(width = 2; width <= DCM300_WIDTH && !bad; width += 2)
+      for(offset = 0; offset < 2 && !bad; offset++)
+      {
+        memset(want, 0xa5, sizeof(want));
+        memset(got, 0xa5, sizeof(got));
+        bayer_downscale_row_scalar(row0 + offset, row1 + offset, want, width);
+        k->downscale(row0 + offset, row1 + offset, got, width);
+        bad = memcmp(want, got, sizeof(got)) != 0;
+        if(bad)
+          fprintf(stderr, "kernel %s differs from scalar at width %d offset %d\n",
+            k->name, width, offset);
+      }
+    printf("%-8s %-6s widths 2-%d %s\n", "check", k->name, DCM300_WIDTH,
+      bad ? "FAILED" : "byte exact");
+    failed |= bad;
+  }
+  return failed ? -1 : 0;
+}
+
+int main(int argc, char **argv)
+{
+  struct bench_geometry *g;
+  struct bench_mode *m;
+  struct bayer_kernel *k;
+  u8 *frame;
+  char *raw;
+
+  if(bench_check_kernels())
+    return 1;
+  printf("%-8s %-6s %-9s %6s %10s %8s %10s\n",
+    "mode", "kernel", "geometry", "frames", "MPix/s", "ns/pix", "MB/s out");
+  for(g = bench_geometry; g->w; g++)
+  {
+    frame = bench_frame(g->w, g->h);
+    if(frame == NULL || (raw = bench_write_frame(frame, g->w, g->h)) == NULL)
+      return 1;
+    for(m = bench_mode; m->name; m++)
+    {
+      if(m->raw || m->demosaic != DEMOSAIC_BIN || m->bin != 2)
+      {
+        bench_pipeline(raw, m, g->w, g->h, "-");
+        continue;
+      }
+      /* 2x2 binning with every kernel this cpu has */
+      for(k = bayer_kernels; k->name; k++)
+        if(k->supported() && bayer_select(k->name))
+          bench_pipeline(raw, m, g->w, g->h, k->name);
+    }
+    for(k = bayer_kernels; k->name; k++)
+      if(k->supported() && bayer_select(k->name))
+        bench_sane(frame, g->w, g->h, k->name);
+    bayer_select(NULL);
+    unlink(raw);
+    free(frame);
+  }
+  return 0;
+}
@@ -3,8 +3,11 @@
 
 typedef unsigned char u8;
 typedef unsigned short int u16;
+typedef unsigned int u32;
+typedef unsigned long long u64;
 
 typedef char s8;
 typedef short int s16;
+typedef int s32;
 
 #endif
@@ -0,0 +1,355 @@
+/* calib.c
+**
+** Dark frame subtraction and flat field correction
+** applied to the raw stream as it arrives, with
+** master frames mapped from the calibration directory
+**
+** License: GPL
+**
+*/
+#include "dcm300.h"
+#include "calib.h"
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/* rows used where a master is missing */
+static const u8 calib_zero[DCM300_WIDTH];
+static u16 calib_unity[DCM300_WIDTH];
+
+int calib_type(char *name)
+{
+  if(strcmp(name, "flat") == 0)
+    return CALIB_FLAT;
+  return CALIB_DARK;
+}
+
+struct calib *calib_create(char *dir)
+{
+  struct calib *c;
+  int i;
+
+  c = calloc(1, sizeof(*c));
+  if(c == NULL)
+    return NULL;
+  c->dir = dir;
+  for(i = 0; i < DCM300_WIDTH; i++)
+    calib_unity[i] = CALIB_ONE;
+  return c;
+}
+
+static void calib_unmap(struct calib_frame *f)
+{
+  if(f->map)
+    munmap(f->map, f->len);
+  memset(f, 0, sizeof(*f));
+}
+
+void calib_destroy(struct calib *c)
+{
+  if(c == NULL)
+    return;
+  calib_unmap(&c->dark);
+  calib_unmap(&c->flat);
+  free(c);
+}
+
+static void calib_name(char *name, char *dir, int type, struct dcm300 *dcm300)
+{
+  if(type == CALIB_FLAT)
+    snprintf(name, PATH_MAX, "%s/flat-r%d-g%d-b%d.cal",
+      dir, dcm300->red, dcm300->green, dcm300->blue);
+  else
+    snprintf(name, PATH_MAX, "%s/dark-e%d-r%d-g%d-b%d.cal",
+      dir, dcm300->exposure, dcm300->red, dcm300->green, dcm300->blue);
+}
+
+/* map master file name, -1 if missing or broken */
+static int calib_map(struct calib_frame *f, char *name, int type)
+{
+  struct calib_header *h;
+  struct stat st;
+  size_t sample = type == CALIB_FLAT ? sizeof(u16) : sizeof(u8);
+  int fd;
+
+  calib_unmap(f);
+  fd = open(name, O_RDONLY);
+  if(fd < 0)
+    return -1;
+  if(fstat(fd, &st) < 0 || st.st_size < (off_t) sizeof(*h))
+  {
+    close(fd);
+    return -1;
+  }
+  f->len = st.st_size;
+  f->map = mmap(NULL, f->len, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if(f->map == MAP_FAILED)
+  {
+    f->map = NULL;
+    return -1;
+  }
+  h = f->map;
+  if(memcmp(h->magic, CALIB_MAGIC, sizeof(h->magic)) != 0
+  || h->version != CALIB_VERSION || h->type != (u32) type
+  || f->len < sizeof(*h) + (size_t) h->w * h->h * sample)
+  {
+    fprintf(stderr, "calibration: bad file %s\n", name);
+    calib_unmap(f);
+    return -1;
+  }
+  f->header = h;
+  f->dark = (const u8 *) (h + 1);
+  f->gain = (const u16 *) (h + 1);
+  snprintf(f->name, sizeof(f->name), "%s", name);
+  return 0;
+}
+
+/* master of the current camera setting, it must cover the window */
+static void calib_select_frame(struct calib *c, struct calib_frame *f,
+                               int type, struct dcm300 *dcm300)
+{
+  char name[PATH_MAX];
+  struct calib_header *h;
+
+  calib_name(name, c->dir, type, dcm300);
+  if(strcmp(name, f->name) != 0 && calib_map(f, name, type) < 0)
+  {
+    if(verbose)
+      fprintf(stderr, "calibration: no %s\n", name);
+    return;
+  }
+  h = f->header;
+  if(dcm300->x < h->x || dcm300->y < h->y
+  || dcm300->x + dcm300->w > h->x + h->w || dcm300->y + dcm300->h > h->y + h->h)
+  {
+    if(verbose)
+      fprintf(stderr, "calibration: %s doesn't cover the window\n", name);
+    calib_unmap(f);
+  }
+}
+
+/* before each snapshot, exposure and gains may have changed.
+** returns 0 if a dark or flat master is in use
+*/
+int calib_select(struct calib *c, struct dcm300 *dcm300)
+{
+  c->x = dcm300->x;
+  c->y = dcm300->y;
+  c->w = dcm300->w;
+  c->h = dcm300->h;
+  calib_select_frame(c, &c->dark, CALIB_DARK, dcm300);
+  calib_select_frame(c, &c->flat, CALIB_FLAT, dcm300);
+  return c->dark.map || c->flat.map ? 0 : -1;
+}
+
+/* (raw - dark) * gain, truncated and saturated to 255 */
+static void calib_correct(u8 *data, const u8 *dark, const u16 *gain, int n)
+{
+  int i = 0;
+  u32 v;
+
+#if defined(__SSE2__)
+  const __m128i zero = _mm_setzero_si128();
+
+  for(; i + 16 <= n; i += 16)
+  {
+    __m128i v8 = _mm_subs_epu8(_mm_loadu_si128((const __m128i *) (data + i)),
+                               _mm_loadu_si128((const __m128i *) (dark + i)));
+    /* (v << 4) * gain >> 16 == v * gain >> 12 */
+    __m128i lo = _mm_mulhi_epu16(_mm_slli_epi16(_mm_unpacklo_epi8(v8, zero), 4),
+                                 _mm_loadu_si128((const __m128i *) (gain + i)));
+    __m128i hi = _mm_mulhi_epu16(_mm_slli_epi16(_mm_unpackhi_epi8(v8, zero), 4),
+                                 _mm_loadu_si128((const __m128i *) (gain + i + 8)));
+    _mm_storeu_si128((__m128i *) (data + i), _mm_packus_epi16(lo, hi));
+  }
+#endif
+  for(; i < n; i++)
+  {
+    v = data[i] > dark[i] ? data[i] - dark[i] : 0;
+    v = (v * gain[i]) >> 12;
+    data[i] = v > 255 ? 255 : v;
+  }
+}
+
+/* correct len bytes of the stream from image offset pos in place.
+** header (negative pos) and footer bytes are left alone
+*/
+void calib_apply(struct calib *c, int pos, u8 *data, int len)
+{
+  struct calib_header *dh = c->dark.header, *fh = c->flat.header;
+  int p, stop, row, col, n;
+  const u8 *dark;
+  const u16 *gain;
+
+  if(dh == NULL && fh == NULL)
+    return;
+  p = pos < 0 ? 0 : pos;
+  stop = pos + len;
+  if(stop > c->w * c->h)
+    stop = c->w * c->h;
+  for(; p < stop; p += n)
+  {
+    row = p / c->w;
+    col = p % c->w;
+    n = c->w - col;
+    if(n > stop - p)
+      n = stop - p;
+    dark = dh ? c->dark.dark + (row + c->y - dh->y) * dh->w + col + c->x - dh->x : calib_zero;
+    gain = fh ? c->flat.gain + (row + c->y - fh->y) * fh->w + col + c->x - fh->x : calib_unity;
+    calib_correct(data + (p - pos), dark, gain, n);
+  }
+}
+
+/* flat gains from the mean flat frame in place of its samples:
+** each pixel is scaled to the mean of its bayer color, after
+** subtracting the dark frame of the same setting if there is one
+*/
+static int calib_flat_gains(struct calib_header *h, u8 *flat, u16 *gain, char *dir,
+                            struct dcm300 *dcm300)
+{
+  struct calib_frame dark[1];
+  char name[PATH_MAX];
+  u64 sum[4] = { 0, 0, 0, 0 }, count[4] = { 0, 0, 0, 0 };
+  u32 x, y, c, v, d, g;
+
+  memset(dark, 0, sizeof(dark));
+  calib_name(name, dir, CALIB_DARK, dcm300);
+  if(calib_map(dark, name, CALIB_DARK) == 0
+  && (dark->header->x != h->x || dark->header->y != h->y
+   || dark->header->w != h->w || dark->header->h != h->h))
+    calib_unmap(dark);
+  if(verbose)
+    fprintf(stderr, "calibration: flat %s dark frame\n", dark->map ? "minus" : "without");
+  for(y = 0; y < h->h; y++)
+    for(x = 0; x < h->w; x++)
+    {
+      d = dark->map ? dark->dark[y * h->w + x] : 0;
+      v = flat[y * h->w + x];
+      v = v > d ? v - d : 0;
+      flat[y * h->w + x] = v;
+      c = (y & 1) * 2 + (x & 1);
+      sum[c] += v;
+      count[c]++;
+    }
+  calib_unmap(dark);
+  for(y = 0; y < h->h; y++)
+    for(x = 0; x < h->w; x++)
+    {
+      c = (y & 1) * 2 + (x & 1);
+      v = flat[y * h->w + x];
+      /* dead pixels get the largest gain, the defect map finds them there */
+      g = v ? (sum[c] * CALIB_ONE + count[c] * v / 2) / (count[c] * v) : 65535;
+      gain[y * h->w + x] = g > 65535 ? 65535 : g;
+    }
+  return 0;
+}
+
+/* take a master frame of the current setting and window,
+** mean of the stack (or CALIB_FRAMES) raw frames
+*/
+int calib_capture(struct dcm300 *dcm300, char *dir, int type)
+{
+  struct dcm300 saved[1];
+  struct calib_header h;
+  char name[PATH_MAX], tmp[PATH_MAX + 8];
+  int fd, size = dcm300->w * dcm300->h;
+  u8 *frame = NULL;
+  u16 *gain = NULL;
+  int mode = STACK_MEAN, captured, result = -1;
+
+  if(mkdir(dir, 0755) < 0 && errno != EEXIST)
+  {
+    perror(dir);
+    return -1;
+  }
+  calib_name(name, dir, type, dcm300);
+  snprintf(tmp, sizeof(tmp), "%s.tmp", name);
+  fd = open(tmp, O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if(fd < 0)
+  {
+    perror(tmp);
+    return -1;
+  }
+  memset(&h, 0, sizeof(h));
+  memcpy(h.magic, CALIB_MAGIC, sizeof(h.magic));
+  h.version = CALIB_VERSION;
+  h.type = type;
+  h.x = dcm300->x;
+  h.y = dcm300->y;
+  h.w = dcm300->w;
+  h.h = dcm300->h;
+  h.exposure = dcm300->exposure;
+  h.red = dcm300->red;
+  h.green = dcm300->green;
+  h.blue = dcm300->blue;
+
+  /* raw uncorrected mean of the frames goes after the header.
+  ** The --stack object is borrowed, its mode is given back
+  */
+  memcpy(saved, dcm300, sizeof(*dcm300));
+  if(dcm300->stack)
+    mode = dcm300->stack->mode;
+  else
+    dcm300->stack = stack_create(STACK_MEAN, CALIB_FRAMES);
+  if(dcm300->stack == NULL)
+    goto out;
+  dcm300->stack->mode = STACK_MEAN;
+  h.frames = dcm300->stack->frames;
+  if(write(fd, &h, sizeof(h)) != sizeof(h))
+    goto out;
+  dcm300->output = fd;
+  dcm300->raw = 1;
+  dcm300->encoder = NULL;
+  dcm300->overlay = NULL;
+  dcm300->calib = NULL;
+  dcm300->defect = NULL;
+  captured = dcm300_get_image(dcm300) == 0 && !dcm300->output_error;
+  if(dcm300->stack != saved->stack)
+    stack_destroy(dcm300->stack);
+  else
+    dcm300->stack->mode = mode;
+  memcpy(dcm300, saved, sizeof(*dcm300));
+  if(!captured || lseek(fd, 0, SEEK_END) != (off_t) (sizeof(h) + size))
+  {
+    fprintf(stderr, "calibration: incomplete frame\n");
+    goto out;
+  }
+
+  if(type == CALIB_FLAT)
+  {
+    frame = malloc(size);
+    gain = malloc(size * sizeof(*gain));
+    if(frame == NULL || gain == NULL
+    || pread(fd, frame, size, sizeof(h)) != size)
+      goto out;
+    calib_flat_gains(&h, frame, gain, dir, dcm300);
+    if(pwrite(fd, gain, size * sizeof(*gain), sizeof(h)) != (ssize_t) (size * sizeof(*gain)))
+      goto out;
+  }
+  if(rename(tmp, name) < 0)
+  {
+    perror(name);
+    goto out;
+  }
+  if(verbose)
+    fprintf(stderr, "calibration: wrote %s\n", name);
+  result = 0;
+out:
+  close(fd);
+  if(result)
+    unlink(tmp);
+  free(frame);
+  free(gain);
+  return result;
+}
@@ -0,0 +1,64 @@
+#ifndef CALIB_H
+#define CALIB_H
+#include <stddef.h>
+#include <limits.h>
+#include "binarytype.h"
+
+/* dark frame and flat field calibration.
+** Master frames are means of CALIB_FRAMES raw frames,
+** one file per type and camera setting in the calibration
+** directory, mapped into memory when a snapshot uses them:
+**
+**   dark-eEXPOSURE-rRED-gGREEN-bBLUE.cal  u8 dark level per pixel
+**   flat-rRED-gGREEN-bBLUE.cal            u16 Q12 gain per pixel
+**
+** file: calib_header then w*h samples of the sensor window
+** the master was taken from, any window inside it can use it.
+** Integers are in host byte order.
+*/
+
+#define CALIB_MAGIC   "DCM300CA"
+#define CALIB_VERSION 1
+
+#define CALIB_DARK 1
+#define CALIB_FLAT 2
+
+#define CALIB_FRAMES 16 /* frames averaged into a master */
+#define CALIB_ONE    4096 /* Q12 gain 1.0 */
+
+struct calib_header {
+  char magic[8]; /* CALIB_MAGIC */
+  u32 version; /* CALIB_VERSION */
+  u32 type; /* CALIB_DARK or CALIB_FLAT */
+  u32 x, y, w, h; /* sensor window of the master */
+  u32 exposure;
+  s32 red, green, blue;
+  u32 frames; /* averaged */
+  u32 reserved[2];
+};
+
+struct calib_frame {
+  char name[PATH_MAX]; /* file mapped, empty if none */
+  void *map; /* whole file */
+  size_t len;
+  struct calib_header *header;
+  const u8 *dark; /* CALIB_DARK samples */
+  const u16 *gain; /* CALIB_FLAT samples */
+};
+
+struct calib {
+  char *dir;
+  int x, y, w, h; /* window of the current snapshot */
+  struct calib_frame dark, flat;
+};
+
+struct dcm300;
+
+int calib_type(char *name);
+struct calib *calib_create(char *dir);
+int calib_select(struct calib *c, struct dcm300 *dcm300);
+void calib_apply(struct calib *c, int pos, u8 *data, int len);
+int calib_capture(struct dcm300 *dcm300, char *dir, int type);
+void calib_destroy(struct calib *c);
+
+#endif
@@ -0,0 +1,387 @@
+/* daemon.c
+**
+** Snapshot daemon: keeps DCM300 open and warm,
+** serves snapshots over a local unix socket
+**
+** License: GPL
+**
+*/
+#include "dcm300.h"
+#include "daemon.h"
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <poll.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <limits.h>
+
+static volatile sig_atomic_t daemon_stop;
+
+static void daemon_signal(int sig)
+{
+  daemon_stop = 1;
+}
+
+static long daemon_ms(void)
+{
+  struct timespec t;
+
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec * 1000L + t.tv_nsec / 1000000L;
+}
+
+static int daemon_address(struct sockaddr_un *addr, char *path)
+{
+  memset(addr, 0, sizeof(*addr));
+  addr->sun_family = AF_UNIX;
+  if(strlen(path) >= sizeof(addr->sun_path))
+  {
+    fprintf(stderr, "socket path too long: %s\n", path);
+    return -1;
+  }
+  strcpy(addr->sun_path, path);
+  return 0;
+}
+
+/* default socket: per user runtime directory, which only
+** its owner can enter, or the system one when run as a service
+*/
+static char *daemon_default_socket(char *path, int maxlen)
+{
+  char *dir = getenv("XDG_RUNTIME_DIR");
+
+  snprintf(path, maxlen, "%s/" DAEMON_SOCKET, dir && *dir ? dir : DAEMON_RUNDIR);
+  return path;
+}
+
+/* remove socket left behind by a daemon that is gone.
+** Returns -1 if a daemon still listens there or the
+** path is not a socket
+*/
+static int daemon_stale(struct sockaddr_un *addr)
+{
+  struct stat st;
+  int fd, result = -1;
+
+  if(lstat(addr->sun_path, &st) < 0)
+    return errno == ENOENT ? 0 : -1;
+  if(!S_ISSOCK(st.st_mode))
+  {
+    fprintf(stderr, "daemon: %s exists and is not a socket\n", addr->sun_path);
+    return -1;
+  }
+  fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if(fd < 0)
+    return -1;
+  if(connect(fd, (struct sockaddr *) addr, sizeof(*addr)) == 0)
+    fprintf(stderr, "daemon: another daemon is listening on %s\n", addr->sun_path);
+  else if(errno != ECONNREFUSED)
+    perror(addr->sun_path);
+  else
+    result = unlink(addr->sun_path);
+  close(fd);
+  return result;
+}
+
+/* snapshot parameters travel as one line of key=value words */
+int daemon_format_request(struct dcm300 *dcm300, char *line, int maxlen)
+{
+  return snprintf(line, maxlen, "exposure=%d red=%d green=%d blue=%d raw=%d demosaic=%d"
+    " bin=%d autoexposure=%d"
+    " whitebalance=%d wb_mode=%d x=%d y=%d w=%d h=%d\n",
+    dcm300->exposure, dcm300->red, dcm300->green, dcm300->blue, dcm300->raw, dcm300->demosaic,
+    dcm300->bin, dcm300->autoexposure, dcm300->whitebalance, dcm300->wb_mode, dcm300->x, dcm300->y, dcm300->w, dcm300->h);
+}
+
+int daemon_parse_request(struct dcm300 *dcm300, char *line)
+{
+  char *word, *value, *save = NULL;
+  char spec[64];
+
+  for(word = strtok_r(line, " \t\r\n", &save); word; word = strtok_r(NULL, " \t\r\n", &save))
+  {
+    value = strchr(word, '=');
+    if(value == NULL)
+      continue;
+    *value++ = 0;
+    if(strcmp(word, "exposure") == 0)
+      dcm300->exposure = atoi(value);
+    else if(strcmp(word, "red") == 0)
+      dcm300->red = atoi(value);
+    else if(strcmp(word, "green") == 0)
+      dcm300->green = atoi(value);
+    else if(strcmp(word, "blue") == 0)
+      dcm300->blue = atoi(value);
+    else if(strcmp(word, "raw") == 0)
+      dcm300->raw = atoi(value);
+    else if(strcmp(word, "demosaic") == 0)
+      dcm300->demosaic = atoi(value);
+    else if(strcmp(word, "bin") == 0)
+      dcm300->bin = atoi(value) == 4 || atoi(value) == 8 ? atoi(value) : 2;
+    else if(strcmp(word, "autoexposure") == 0)
+      dcm300->autoexposure = atoi(value) && dcm300->meter ? 1 : 0;
+    else if(strcmp(word, "whitebalance") == 0)
+      dcm300->whitebalance = atoi(value) && dcm300->meter ? 1 : 0;
+    else if(strcmp(word, "wb_mode") == 0)
+      dcm300->wb_mode = atoi(value) == METER_BRIGHTEST ? METER_BRIGHTEST : METER_GRAY_WORLD;
+    else if(strcmp(word, "x") == 0)
+      dcm300->x = atoi(value);
+    else if(strcmp(word, "y") == 0)
+      dcm300->y = atoi(value);
+    else if(strcmp(word, "w") == 0)
+      dcm300->w = atoi(value);
+    else if(strcmp(word, "h") == 0)
+      dcm300->h = atoi(value);
+    else if(verbose)
+      fprintf(stderr, "daemon: unknown request parameter %s\n", word);
+  }
+  /* same alignment and limits as --geometry */
+  snprintf(spec, sizeof(spec), "%dx%d+%d+%d", dcm300->w, dcm300->h, dcm300->x, dcm300->y);
+  return dcm300_geometry(dcm300, spec);
+}
+
+/* read request line from the client, up to and including '\n'.
+** A client that sends nothing within DAEMON_REQUEST_MS gets
+** dropped, it must not stall the daemon and its keep-alive
+*/
+static int daemon_read_request(int fd, char *line, int maxlen)
+{
+  struct pollfd pfd;
+  long deadline = daemon_ms() + DAEMON_REQUEST_MS, left;
+  int n = 0, len;
+
+  while(n < maxlen - 1)
+  {
+    left = deadline - daemon_ms();
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    if(left <= 0 || poll(&pfd, 1, left) <= 0)
+    {
+      n = 0;
+      break;
+    }
+    len = read(fd, line + n, 1);
+    if(len <= 0)
+      break;
+    if(line[n++] == '\n')
+      break;
+  }
+  line[n] = 0;
+  return n;
+}
+
+/* serve snapshot requests until SIGINT or SIGTERM.
+** Device is opened once. When idle, a small snapshot is taken
+** every DAEMON_KEEPALIVE_MS to keep the camera in the stable state,
+** so real snapshots don't need the warm-up.
+** Exposure and gains metered for one request are where
+** metering starts for the next, so they converge across
+** requests as in preview.
+** path NULL is the default socket. Its mode comes from the
+** umask, who may take snapshots is up to the directory
+** and umask the daemon is started with
+*/
+int dcm300_daemon(struct dcm300 *dcm300, char *path)
+{
+  struct sockaddr_un addr;
+  struct pollfd pfd;
+  struct dcm300 defaults[1];
+  char line[DAEMON_LINE], buffer[PATH_MAX];
+  int sfd, client, ready;
+  int exposure = 0, gains = 0; /* 1-metered value below is kept */
+  u16 metered_exposure = 0;
+  s8 metered_red = 0, metered_green = 0, metered_blue = 0;
+
+  if(path == NULL)
+    path = daemon_default_socket(buffer, sizeof(buffer));
+  if(daemon_address(&addr, path) || daemon_stale(&addr))
+    return -1;
+  sfd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if(sfd < 0)
+  {
+    perror("daemon: socket");
+    return -1;
+  }
+  if(bind(sfd, (struct sockaddr *) &addr, sizeof(addr)) < 0 || listen(sfd, 4) < 0)
+  {
+    perror(path);
+    close(sfd);
+    return -1;
+  }
+  /* client may hang up during the image, we still read all bulks */
+  signal(SIGPIPE, SIG_IGN);
+  /* stop between snapshots and remove the socket */
+  daemon_stop = 0;
+  signal(SIGINT, daemon_signal);
+  signal(SIGTERM, daemon_signal);
+
+  memcpy(defaults, dcm300, sizeof(*dcm300));
+  /* warm from the start, this reads the first bulk */
+  dcm300->quiet = 1;
+  dcm300_warmup(dcm300);
+  dcm300->quiet = defaults->quiet;
+  /* startup is reported once, not again with every request */
+  defaults->t_startup = 0;
+  if(verbose)
+    fprintf(stderr, "daemon: listening on %s\n", path);
+
+  while(!daemon_stop)
+  {
+    pfd.fd = sfd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    ready = poll(&pfd, 1, DAEMON_KEEPALIVE_MS);
+    /* interrupted, see if it was a stop signal */
+    if(ready < 0)
+      continue;
+    if(ready == 0)
+    {
+      /* idle, keep the camera warm */
+      dcm300->quiet = 1;
+      dcm300_warmup(dcm300);
+      dcm300->quiet = defaults->quiet;
+      continue;
+    }
+    client = accept(sfd, NULL, NULL);
+    if(client < 0)
+      continue;
+    if(daemon_read_request(client, line, sizeof(line)) > 0)
+    {
+      /* each request starts from daemon's own settings,
+      ** the session knows if the camera is still warm */
+      memcpy(dcm300, defaults, sizeof(*dcm300));
+      daemon_parse_request(dcm300, line);
+      /* metering goes on from the last metered request */
+      if(dcm300->autoexposure && exposure)
+        dcm300->exposure = metered_exposure;
+      if(dcm300->whitebalance && gains)
+      {
+        dcm300->red = metered_red;
+        dcm300->green = metered_green;
+        dcm300->blue = metered_blue;
+      }
+      dcm300->output = client;
+      if(dcm300_get_image(dcm300) == 0)
+      {
+        if(dcm300->autoexposure)
+        {
+          metered_exposure = dcm300->exposure;
+          exposure = 1;
+        }
+        if(dcm300->whitebalance)
+        {
+          metered_red = dcm300->red;
+          metered_green = dcm300->green;
+          metered_blue = dcm300->blue;
+          gains = 1;
+        }
+      }
+      /* cumulative, one line per snapshot */
+      if(dcm300->stats)
+        stats_report(dcm300->stats);
+    }
+    close(client);
+  }
+  signal(SIGINT, SIG_DFL);
+  signal(SIGTERM, SIG_DFL);
+  close(sfd);
+  unlink(path);
+  if(verbose)
+    fprintf(stderr, "daemon: stopped\n");
+  return 0;
+}
+
+/* daemon streams PNM "P6\nW H\n255\n" and RGB rows,
+** pass them through our own output so the image gets
+** our encoder and scale bar
+*/
+static int daemon_client_image(struct dcm300 *dcm300, int fd)
+{
+  char buffer[MAXBULK];
+  int i, len = 0, lines = 0, w, h;
+  int scale = dcm300_scale(dcm300);
+
+  for(i = 0; lines < 3; i++)
+  {
+    if(i == len)
+    {
+      if(len == sizeof(buffer) || (len += read(fd, buffer + len, sizeof(buffer) - len)) <= i)
+        return -1;
+    }
+    if(buffer[i] == '\n')
+      lines++;
+  }
+  if(sscanf(buffer, "P6 %d %d", &w, &h) != 2)
+    return -1;
+  dcm300->w = w * scale;
+  dcm300->h = h * scale;
+  if(dcm300_output_header(dcm300))
+    return -1;
+  dcm300_output_rgb(dcm300, (u8 *) buffer + i, len - i);
+  while((len = read(fd, buffer, sizeof(buffer))) > 0)
+    if(dcm300_output_rgb(dcm300, (u8 *) buffer, len) < 0)
+      break;
+  /* daemon failed to read the whole frame */
+  if(len < 0 || dcm300->rgb_out < 3 * w * h)
+    dcm300->output_error = 1;
+  if(dcm300_output_end(dcm300))
+    return -1;
+  return dcm300->output_error ? -1 : 0;
+}
+
+/* thin client: send our parameters to the daemon and
+** copy the image it streams back to our output.
+** returns 1 if no daemon is listening, -1 if the image
+** didn't arrive or couldn't be written
+*/
+int dcm300_client(struct dcm300 *dcm300, char *path)
+{
+  struct sockaddr_un addr;
+  char line[DAEMON_LINE];
+  char buffer[MAXBULK];
+  int fd, len, result = 0;
+
+  if(daemon_address(&addr, path))
+    return 1;
+  fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if(fd < 0)
+    return 1;
+  if(connect(fd, (struct sockaddr *) &addr, sizeof(addr)) < 0)
+  {
+    close(fd);
+    return 1;
+  }
+  len = daemon_format_request(dcm300, line, sizeof(line));
+  if(write(fd, line, len) != len)
+  {
+    close(fd);
+    return 1;
+  }
+  if((dcm300->encoder || dcm300->overlay) && !dcm300->raw)
+  {
+    result = daemon_client_image(dcm300, fd);
+    if(result)
+      fprintf(stderr, "client: bad image from daemon\n");
+  }
+  else
+  {
+    while((len = read(fd, buffer, sizeof(buffer))) > 0)
+      if(write(dcm300->output, buffer, len) != len)
+        break;
+    if(len != 0)
+    {
+      perror("client");
+      result = -1;
+    }
+  }
+  close(fd);
+  return result;
+}
@@ -0,0 +1,17 @@
+#ifndef DAEMON_H
+#define DAEMON_H
+
+#define DAEMON_SOCKET "dcm300.sock" /* in $XDG_RUNTIME_DIR, else in DAEMON_RUNDIR */
+#define DAEMON_RUNDIR "/run"
+#define DAEMON_KEEPALIVE_MS 1000 /* idle camera gets a small snapshot this often */
+#define DAEMON_LINE 256 /* max length of request line */
+#define DAEMON_REQUEST_MS 500 /* client must send its request line within this */
+
+struct dcm300;
+
+int daemon_format_request(struct dcm300 *dcm300, char *line, int maxlen);
+int daemon_parse_request(struct dcm300 *dcm300, char *line);
+int dcm300_daemon(struct dcm300 *dcm300, char *path);
+int dcm300_client(struct dcm300 *dcm300, char *path);
+
+#endif
@@ -2,16 +2,18 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
+#include <time.h>
 #include <stdio.h>
 #include <unistd.h>
 #include <string.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <signal.h>
 
 int verbose = 0;
 
-struct dcm300 dcm300_device;
-struct dcm300 *dcm300 = &dcm300_device;
 struct usb_vendor_product usb_vendor_product_list[] = {
-  { 0x1578, 0x0076, "DCM300" },
+  { DCM300_VENDOR, DCM300_PRODUCT, "DCM300" },
   { 0, 0, NULL },
 };
 
@@ -80,13 +82,37 @@ int dcm300_write_simulation(struct dcm300 *dcm300, u8 *buffer, int bytes)
 }
 
 
-int dcm300_find_hardware(struct dcm300 *dcm300)
+/* camera selected by Bus:Device or port id: straight
+** to its usbfs device node, no scan of every bus
+*/
+static int dcm300_open_node(struct dcm300 *dcm300)
+{
+  char path[PATH_MAX];
+
+  if(dcm300_camera_node(dcm300->name, path, sizeof(path)))
+  {
+    fprintf(stderr, "no camera %s, see --list\n", dcm300->name);
+    return -1;
+  }
+  if(usbfs_open(dcm300, path))
+    return -1;
+  if(dcm300->urbs > 0 && usbfs_queue_create(dcm300, dcm300->urbs, dcm300->bulk))
+  {
+    usbfs_close(dcm300);
+    return -1;
+  }
+  return 0;
+}
+
+/* first supported device of a full libusb bus scan */
+static int dcm300_scan_hardware(struct dcm300 *dcm300)
 {
   struct usb_bus *busses;
   struct usb_bus *bus;
   struct usb_device *dev;
   usb_dev_handle *usbdev;
   struct usb_vendor_product *supported;
+  char path[PATH_MAX];
   int i;
 
   /* Find the device */
@@ -107,6 +133,19 @@ int dcm300_find_hardware(struct dcm300 *dcm300)
         {
           fprintf(stderr, "found: %s\n", supported->name);
           /* supported device found */
+          if(dcm300->urbs > 0)
+          {
+            /* asynchronous transfers go directly through usbfs node */
+            snprintf(path, sizeof(path), "/dev/bus/usb/%03d/%03d", atoi(bus->dirname), atoi(dev->filename));
+            if(usbfs_open(dcm300, path))
+              continue;
+            if(usbfs_queue_create(dcm300, dcm300->urbs, dcm300->bulk))
+            {
+              usbfs_close(dcm300);
+              return -1;
+            }
+            return 0;
+          }
 	  usbdev = usb_open(dev);
 	  dcm300->usb_dev_handle = usbdev;
 #if 0
@@ -130,10 +169,24 @@ int dcm300_find_hardware(struct dcm300 *dcm300)
 
 }
 
+int dcm300_find_hardware(struct dcm300 *dcm300)
+{
+  u64 t = dcm300_ns();
+  int result;
+
+  result = dcm300->name ? dcm300_open_node(dcm300) : dcm300_scan_hardware(dcm300);
+  if(verbose && result == 0)
+    fprintf(stderr, "camera open: %.1f ms (%s)\n", (dcm300_ns() - t) * 1e-6,
+      dcm300->name ? "direct" : "bus scan");
+  return result;
+}
+
 int dcm300_write_hardware(struct dcm300 *dcm300, u8 *buffer, int bytes)
 {
-  if(dcm300->simulation == 1)
+  if(dcm300->simulation)
     return 0;
+  if(dcm300->usbfs >= 0)
+    return usbfs_bulk_write(dcm300, buffer, bytes, 500);
   if(dcm300->usb_dev_handle)
     return usb_bulk_write(dcm300->usb_dev_handle, 2, (char *) buffer, bytes, 500);
   return 0;
@@ -141,53 +194,217 @@ int dcm300_write_hardware(struct dcm300 *dcm300, u8 *buffer, int bytes)
 
 int dcm300_read_hardware(struct dcm300 *dcm300, u8 *buffer, int bytes)
 {
-  if(dcm300->simulation == 1)
+  if(dcm300->simulation)
     return 0;
+  if(dcm300->queue)
+    return usbfs_queue_read(dcm300, buffer, bytes, 2000);
+  if(dcm300->usbfs >= 0)
+    return usbfs_bulk_read(dcm300, buffer, bytes, 2000);
   if(dcm300->usb_dev_handle)
     return usb_bulk_read(dcm300->usb_dev_handle, 6, (char *)buffer, bytes, 2000);
   return 0;
 }
 
-int dcm300_create_request(struct dcm300 *dcm300, struct dcm300_request *r)
+/* parse WxH+X+Y, or WxH for a window in the center.
+** Size is rounded down to DCM300_ALIGN_X/Y, offset to even
+** pixels to keep the RGGB phase, and the window is
+** moved inside the sensor
+*/
+int dcm300_geometry(struct dcm300 *dcm300, char *spec)
 {
-  memset(r, 0, sizeof(*r));
-  
-  r->unknown1a = 0x2c;
-  r->unknown1b = 0x0e;
-  r->unknown1c = 0x01;
+  int w, h, x = 0, y = 0, n;
 
-  r->unknown2 = 0x20;
-  r->unknown3 = 0x05;
-  r->unknown9 = 0x02;
-  
-  r->resolution_x_lo = (dcm300->w) % 256;
-  r->resolution_x_hi = (dcm300->w) / 256;
-  r->resolution_y_lo = (dcm300->h) % 256;
-  r->resolution_y_hi = (dcm300->h) / 256;
+  n = sscanf(spec, "%dx%d+%d+%d", &w, &h, &x, &y);
+  if(n != 2 && n != 4)
+  {
+    fprintf(stderr, "geometry must be WxH+X+Y or WxH: %s\n", spec);
+    return -1;
+  }
+  w -= w % DCM300_ALIGN_X;
+  h -= h % DCM300_ALIGN_Y;
+  if(w < DCM300_ALIGN_X)
+    w = DCM300_ALIGN_X;
+  if(h < DCM300_ALIGN_Y)
+    h = DCM300_ALIGN_Y;
+  if(w > DCM300_WIDTH)
+    w = DCM300_WIDTH;
+  if(h > DCM300_HEIGHT)
+    h = DCM300_HEIGHT;
+  if(n == 2)
+  {
+    x = (DCM300_WIDTH - w) / 2;
+    y = (DCM300_HEIGHT - h) / 2;
+  }
+  x &= ~1;
+  y &= ~1;
+  if(x < 0)
+    x = 0;
+  if(y < 0)
+    y = 0;
+  if(x + w > DCM300_WIDTH)
+    x = DCM300_WIDTH - w;
+  if(y + h > DCM300_HEIGHT)
+    y = DCM300_HEIGHT - h;
+  dcm300->x = x;
+  dcm300->y = y;
+  dcm300->w = w;
+  dcm300->h = h;
+  if(verbose)
+    fprintf(stderr, "geometry %dx%d+%d+%d\n", w, h, x, y);
+  return 0;
+}
 
-  r->offset_x_lo = (dcm300->x) % 256;
-  r->offset_x_hi = (dcm300->x) / 256;
+/* window, exposure, gains and output of the next snapshot */
+static void dcm300_settings(struct dcm300 *dcm300, struct dcm300_snapshot *s)
+{
+  memset(s, 0, sizeof(*s));
+  s->x = dcm300->x;
+  s->y = dcm300->y;
+  s->w = dcm300->w;
+  s->h = dcm300->h;
+  s->exposure = dcm300->exposure;
+  s->red = dcm300->red;
+  s->green = dcm300->green;
+  s->blue = dcm300->blue;
+  s->bin = dcm300_scale(dcm300);
+  s->method = dcm300->demosaic;
+  s->threads = dcm300->threads;
+  s->raw = dcm300->raw;
+  s->frames = dcm300->stack ? dcm300->stack->frames : 0;
+}
 
-  r->offset_y_lo = (dcm300->y) % 256;
-  r->offset_y_hi = (dcm300->y) / 256;
+/* transport of the session: raw file, trace or camera */
+static int dcm300_transport_write(void *ctx, u8 *data, int len)
+{
+  return dcm300_write((struct dcm300 *) ctx, data, len);
+}
 
-  r->exposure_lo = (dcm300->exposure + 20) % 256;
-  r->exposure_hi = (dcm300->exposure + 20) / 256;
+static int dcm300_transport_read(void *ctx, u8 *data, int len)
+{
+  return dcm300_read((struct dcm300 *) ctx, data, len);
+}
 
-  r->gain_red   = dcm300->red;
-  r->gain_green = dcm300->green;
-  r->gain_blue  = dcm300->blue;
+static int dcm300_transport_expect(void *ctx, int image_bytes)
+{
+  return dcm300_expect((struct dcm300 *) ctx, image_bytes);
+}
 
-  r->gamma = 191;
+/* warm-up and metering frames are timed but counted
+** apart, each frame is metered and defect corrected on
+** its own. Progress marks: [ header . bulk ] footer
+*/
+static void dcm300_hook_event(void *param, int event, const struct dcm300_snapshot *s)
+{
+  struct dcm300 *dcm300 = param;
 
-  return 0;
+  switch(event)
+  {
+    case DCM300_EVENT_WARMUP:
+    case DCM300_EVENT_FRAME:
+      dcm300->warming = event == DCM300_EVENT_WARMUP;
+      if(dcm300->stats)
+        dcm300->stats->warmup = dcm300->warming;
+      if(dcm300->meter)
+        meter_reset(dcm300->meter, s->w, s->h);
+      if(dcm300->defect)
+        defect_start(dcm300->defect);
+      break;
+    case DCM300_EVENT_HEADER:
+      dcm300_progress(dcm300, "[");
+      break;
+    case DCM300_EVENT_BULK:
+      dcm300_progress(dcm300, ".");
+      break;
+    case DCM300_EVENT_FOOTER:
+      dcm300_progress(dcm300, "]");
+      break;
+  }
 }
 
+/* dark, flat and defect correction of the bytes just read */
+static void dcm300_hook_correct(void *param, struct ring *ring, int pos, int len)
+{
+  struct dcm300 *dcm300 = param;
+
+  if(dcm300->calib)
+    calib_apply(dcm300->calib, pos, ring_at(ring, pos), len);
+  if(dcm300->defect)
+    defect_apply(dcm300->defect, ring, pos, len);
+}
+
+static void dcm300_hook_meter(void *param, int pos, const u8 *data, int len)
+{
+  struct dcm300 *dcm300 = param;
+
+  if(dcm300->meter)
+    meter_add(dcm300->meter, pos, data, len);
+}
+
+static void dcm300_hook_stack_add(void *param, int pos, const u8 *data, int len)
+{
+  stack_add(((struct dcm300 *) param)->stack, pos, data, len);
+}
+
+static void dcm300_hook_stack_result(void *param, int frames, int pos, u8 *out, int len)
+{
+  struct stack *s = ((struct dcm300 *) param)->stack;
+
+  s->added = frames;
+  stack_result(s, pos, out, len);
+}
+
+static void dcm300_hook_convert(void *param, u64 ns, int bytes)
+{
+  struct dcm300 *dcm300 = param;
+
+  if(dcm300->stats)
+    stats_add(dcm300->stats, STATS_DEMOSAIC, ns, bytes);
+}
+
+/* capture session on our transport. Hooks look at the
+** settings of each snapshot, calibration, meter and stack
+** may come and go between snapshots
+*/
+static int dcm300_session_open(struct dcm300 *dcm300)
+{
+  struct dcm300_transport t = {
+    dcm300_transport_write, dcm300_transport_read, dcm300, dcm300_transport_expect
+  };
+  struct dcm300_config config = {
+    dcm300->bulk, dcm300->ring_size, dcm300->pipeline_depth, dcm300->simulation == 1
+  };
+  struct dcm300_hooks hooks = {
+    dcm300_hook_event, dcm300_hook_correct, dcm300_hook_meter,
+    dcm300_hook_stack_add, dcm300_hook_stack_result, dcm300_hook_convert, dcm300
+  };
+
+  dcm300->session = dcm300_session_create(&t, &config, &hooks);
+  if(dcm300->session == NULL)
+    return -1;
+  if(dcm300->stats)
+    dcm300->stats->pipeline = dcm300_session_pipeline(dcm300->session);
+  return 0;
+}
 
 int dcm300_open(struct dcm300 *dcm300)
 {
+  if (dcm300_session_open(dcm300))
+    return -1;
+  dcm300->record = NULL;
+  dcm300->replay = NULL;
+  if (dcm300->record_name)
+  {
+    dcm300->record = trace_create(dcm300->record_name);
+    if (dcm300->record == NULL)
+      return -1;
+  }
   if (dcm300->simulation == 1)
     return dcm300_open_simulation(dcm300);
+  if (dcm300->simulation == 2)
+  {
+    dcm300->replay = trace_open(dcm300->name);
+    return dcm300->replay ? 0 : -1;
+  }
   else
   {
     if(dcm300_find_hardware(dcm300))
@@ -203,161 +420,293 @@ int dcm300_open(struct dcm300 *dcm300)
 
 int dcm300_close(struct dcm300 *dcm300)
 {
+  dcm300_session_destroy(dcm300->session);
+  dcm300->session = NULL;
+  trace_close(dcm300->record);
+  dcm300->record = NULL;
   if (dcm300->simulation == 1)
     return dcm300_close_simulation(dcm300);
+  if (dcm300->simulation == 2)
+  {
+    trace_close(dcm300->replay);
+    dcm300->replay = NULL;
+    return 0;
+  }
+  if (dcm300->usbfs >= 0)
+    return usbfs_close(dcm300);
+  if (dcm300->usb_dev_handle)
+  {
+    usb_release_interface(dcm300->usb_dev_handle, 0);
+    usb_close(dcm300->usb_dev_handle);
+    dcm300->usb_dev_handle = NULL;
+    return 0;
+  }
   return -1;
 }
 
+/*
+** announce the image size of the next request.
+** with asynchronous transfers this queues URBs
+** for the whole frame before the request is sent
+*/
+int dcm300_expect(struct dcm300 *dcm300, int image_bytes)
+{
+  if (dcm300->simulation)
+    return 0;
+  if (dcm300->queue)
+    return usbfs_queue_frame(dcm300, image_bytes);
+  return 0;
+}
+
+/*
+** read and write go to the raw file, the replayed trace
+** or the camera. Each transfer is appended to the trace
+** being recorded together with its timing
+*/
 int dcm300_read(struct dcm300 *dcm300, u8 *buffer, int bytes)
 {
+  u64 t = dcm300_ns();
+  int result;
+
   if (dcm300->simulation == 1)
-    return dcm300_read_simulation(dcm300, buffer, bytes);
+    result = dcm300_read_simulation(dcm300, buffer, bytes);
+  else if (dcm300->simulation == 2)
+    result = trace_read(dcm300->replay, buffer, bytes);
   else
-    return dcm300_read_hardware(dcm300, buffer, bytes);
-  return -1;
+    result = dcm300_read_hardware(dcm300, buffer, bytes);
+  if (!dcm300->warming && result > 0)
+    dcm300->bytes += result;
+  if (dcm300->t_startup && result > 0)
+  {
+    if (verbose)
+      fprintf(stderr, "startup to first bulk: %.1f ms\n", (dcm300_ns() - dcm300->t_startup) * 1e-6);
+    dcm300->t_startup = 0;
+  }
+  if (dcm300->record)
+    trace_add(dcm300->record, TRACE_READ, bytes, result, t, buffer);
+  if (dcm300->stats)
+    stats_read(dcm300->stats, bytes, result, t);
+  return result;
 }
 
 int dcm300_write(struct dcm300 *dcm300, u8 *buffer, int bytes)
 {
+  u64 t = dcm300_ns();
+  int result;
+
   if (dcm300->simulation == 1)
-    return dcm300_write_simulation(dcm300, buffer, bytes);
+    result = dcm300_write_simulation(dcm300, buffer, bytes);
+  else if (dcm300->simulation == 2)
+    result = trace_write(dcm300->replay, buffer, bytes);
   else
-    return dcm300_write_hardware(dcm300, buffer, bytes);
-  return -1;
+    result = dcm300_write_hardware(dcm300, buffer, bytes);
+  if (dcm300->record)
+    trace_add(dcm300->record, TRACE_WRITE, bytes, result, t, buffer);
+  if (dcm300->stats)
+    stats_write(dcm300->stats, bytes, result, t);
+  return result;
 }
 
-/*
-** pointer of the next byte to be written in the circular buffer
-*/
-u8* dcm300_circular(struct dcm300 *dcm300)
+/* progress marks on stderr: [ header . bulk ] footer */
+void dcm300_progress(struct dcm300 *dcm300, char *mark)
 {
-  return dcm300->bayer_circular + ((unsigned int)(dcm300->bayer_read) % BAYER_CIRCULAR);
+  if(!dcm300->quiet)
+    fputs(mark, stderr);
 }
 
-
-/* do the bayer on-the-fly using a circular buffer */
-int dcm300_output_bayer(struct dcm300 *dcm300, int len)
+/* write to the output or its encoder,
+** timed when collecting stats
+*/
+static int dcm300_output_encode(struct dcm300 *dcm300, void *data, int len)
 {
-  int  i, j, irgb;
-  u8 rgb_array[RGB_MAX];
-  u8 *bayer_array;
-  int *bayer_start, bayer_stop, bayer_last, bayer_width;
-
-  bayer_array = dcm300->bayer_circular;
+  if(dcm300->encoder && !dcm300->raw)
+    return encode_write(dcm300->encoder, data, len);
+  return write(dcm300->output, data, len);
+}
 
-#if 0
-  fprintf(stderr, "bayer from=%08x read=%08x len=%d\n",
-   dcm300->bayer_from, dcm300->bayer_read, len);
+int dcm300_output_write(struct dcm300 *dcm300, void *data, int len)
+{
+  u64 t;
+  int result;
+
+  if(dcm300->stats == NULL || len == 0)
+    return dcm300_output_encode(dcm300, data, len);
+  t = dcm300_ns();
+  result = dcm300_output_encode(dcm300, data, len);
+  stats_add(dcm300->stats, STATS_OUTPUT, dcm300_ns() - t, result);
+  return result;
+}
 
-  fprintf(stderr, "image %dx%d\n", dcm300->w, dcm300->h);
-#endif
+/* write RGB rows (raw bayer bytes in raw mode) to the output */
+int dcm300_output_rgb(struct dcm300 *dcm300, u8 *rgb, int len)
+{
+  int result;
 
-  bayer_width = dcm300->bayer_width;
-  bayer_start = &(dcm300->bayer_from);
-  bayer_stop = dcm300->bayer_read + len;
-  if(bayer_stop > dcm300->bayer_end)
-    bayer_stop = dcm300->bayer_end;
-  /* even number of bayer lines because they come as alternating RG and GB rows*/  
-  bayer_last = *bayer_start + (bayer_stop - *bayer_start) - ((bayer_stop - *bayer_start) % (2*bayer_width));
-#if 0
-  fprintf(stderr, "bayer: start=%d read=%d stop=%d last=%d width=%d ", 
-    *bayer_start, dcm300->bayer_read, bayer_stop, bayer_last, bayer_width);
-#endif
-  irgb = 0;
-  for(i = *bayer_start; i < bayer_last; i += 2*bayer_width )
-  {
-    for(j = i; j < i + bayer_width; j += 2)
-    {
-      rgb_array[irgb++] = bayer_array[ (j) % BAYER_CIRCULAR];
-      rgb_array[irgb++] = (bayer_array[ (j + 1) % BAYER_CIRCULAR] + bayer_array[ (j + bayer_width) % BAYER_CIRCULAR ])/2;
-      rgb_array[irgb++] = bayer_array[ (j + bayer_width + 1) % BAYER_CIRCULAR];
-      if(irgb > RGB_MAX)
-      {
-        // DBG(1, "cat't fit to rgb - need bayer force exit\n");
-        goto force_exit;
-      }
-    }
-  }
-  
-  force_exit:;
-  
-  *bayer_start = i;
-  dcm300->bayer_read = i;
-  // *rgb_len = irgb;
-  /* write the data */
-#if 0
-  fprintf(stderr, "bayer out irgb=%d\n", irgb);
-#endif
-  write(dcm300->output, rgb_array, irgb);
+  dcm300->rgb_out += len;
+  result = dcm300_output_write(dcm300, rgb, len) == len ? 0 : -1;
+  if(result < 0)
+    dcm300->output_error = 1;
+  return result;
+}
 
+/* rows of the session, on the writer thread when pipelined.
+** A failed write doesn't stop reading the frame, it is
+** left in output_error
+*/
+static int dcm300_rows(void *param, unsigned bytes, void *data)
+{
+  dcm300_output_rgb((struct dcm300 *) param, data, bytes);
   return 0;
 }
 
-/* output raw ayer data or make the downscale to RGB */
-int dcm300_output(struct dcm300 *dcm300, int len)
+/* sensor pixels per output pixel in each direction */
+int dcm300_scale(struct dcm300 *dcm300)
 {
-  if(len > 0)
-  {
-   if(dcm300->raw)
-     write(dcm300->output, dcm300_circular(dcm300), len);
-   else
-     dcm300_output_bayer(dcm300, len);
-  }
-  return 0;
+  if(dcm300->demosaic != DEMOSAIC_BIN)
+    return 1;
+  return dcm300->bin > 2 ? dcm300->bin : 2;
 }
 
 /* output image header */
 int dcm300_output_header(struct dcm300 *dcm300)
 {
-  char *buffer;
-  
-  buffer = (char *)dcm300_circular(dcm300);
-  
+  char buffer[64];
+  int scale = dcm300_scale(dcm300);
+  int height = dcm300->h / scale;
+
+  dcm300->rgb_out = 0;
+  dcm300->output_error = 0;
+  /* scale bar strip is part of the image */
+  if(dcm300->overlay && !dcm300->raw)
+    height += overlay_rows(dcm300->overlay, dcm300->w / scale, scale);
+
+  /* encoder writes its own header */
+  if(dcm300->encoder && !dcm300->raw)
+    return encode_begin(dcm300->encoder, dcm300->output, dcm300->w / scale, height);
+
   *buffer = 0;
   
   if(dcm300->raw)
     sprintf(buffer, "%s", "");
   else
-    sprintf(buffer, "P6\n%d %d\n255\n", dcm300->w / 2, dcm300->h / 2);
+    sprintf(buffer, "P6\n%d %d\n255\n", dcm300->w / scale, height);
    
-  write(dcm300->output, buffer, strlen(buffer));
+  dcm300_output_write(dcm300, buffer, strlen(buffer));
+
+  return 0;
+}
+
+/* after the last image row: scale bar strip and end
+** of the encoded file. Rows of a short image are black,
+** so the strip stays at the bottom
+*/
+int dcm300_output_end(struct dcm300 *dcm300)
+{
+  static const u8 black[4096];
+  struct overlay *o = dcm300->overlay;
+  int scale = dcm300_scale(dcm300);
+  int missing, len;
+
+  if(dcm300->raw)
+    return 0;
+  if(o && o->rows > 0)
+  {
+    missing = 3 * (dcm300->w / scale) * (dcm300->h / scale) - dcm300->rgb_out;
+    for(; missing > 0; missing -= len)
+    {
+      len = missing < (int) sizeof(black) ? missing : (int) sizeof(black);
+      dcm300_output_rgb(dcm300, (u8 *) black, len);
+    }
+    dcm300_output_rgb(dcm300, o->strip, 3 * o->rows * o->width);
+  }
+  if(dcm300->encoder)
+    return encode_end(dcm300->encoder);
+  return 0;
+}
+
+/* by experimentation I've found out that
+** there must be 2 consecutive snapshotting with
+** dcm300 otherwise it becomes unstable 
+** (bulk read may fail)
+** to gain some speed, we take small snapshot of
+** 128x128 size. It is taken from the center of the
+** requested window and only used for metering.
+*/
+int dcm300_warmup(struct dcm300 *dcm300)
+{
+  struct dcm300_snapshot s[1];
+
+  /* same window as the SANE backend's warm-up */
+  dcm300_settings(dcm300, s);
+  return dcm300_session_warmup(dcm300->session, s);
+}
+
+/* exposure and gains for the next frame from the
+** metered one. Returns 1 if anything was changed
+*/
+int dcm300_meter_adjust(struct dcm300 *dcm300)
+{
+  int exposure, changed = 0;
 
+  if(dcm300->autoexposure)
+  {
+    exposure = meter_exposure(dcm300->meter, dcm300->exposure);
+    changed = exposure != dcm300->exposure;
+    dcm300->exposure = exposure;
+  }
+  if(dcm300->whitebalance)
+    changed |= meter_whitebalance(dcm300->meter, dcm300->wb_mode,
+      &dcm300->red, &dcm300->green, &dcm300->blue);
+  return changed;
+}
+
+/* meter the warm-up frame and repeat tiny frames
+** until exposure and white balance settle. In the usual
+** case the warm-up alone is enough and costs nothing extra
+*/
+int dcm300_meter(struct dcm300 *dcm300)
+{
+  int round;
+
+  for(round = 0; round < METER_ROUNDS; round++)
+  {
+    if(dcm300_warmup(dcm300))
+      return -1;
+    if(!dcm300_meter_adjust(dcm300))
+      break;
+  }
   return 0;
 }
 
+/* snapshot to the output. Returns -1 if the camera
+** failed to deliver the whole frame, output errors
+** are left in output_error
+*/
 int dcm300_get_image(struct dcm300 *dcm300)
 {
-  int i, len, want_bytes;
-  int expect_image;
-  struct dcm300 dcm300small[1];
-  struct dcm300_request request[1];
-
-  /* by experimentation I've found out that
-  ** there must be 2 consecutive snapshotting with
-  ** dcm300 otherwise it becomes unstable 
-  ** (bulk read may fail)
-  ** to gain some speed, we take small snapshot of
-  ** 128x128 size. We don't use image obtained here.
+  struct dcm300_snapshot s[1];
+  const struct dcm300_pipeline_stats *p;
+  int result;
+
+  /* metering leaves the camera warm. Without it the
+  ** session warms it up unless it completed a frame
+  ** a moment ago (daemon, preview)
   */
-  memcpy(dcm300small, dcm300, sizeof(*dcm300));
-  dcm300small->x = dcm300small->y = 0;
-  dcm300small->w = dcm300small->h = 128;
-  expect_image = dcm300small->w * dcm300small->h;
-  dcm300_create_request(dcm300small, request);
-  dcm300_write(dcm300small, (u8 *) request, sizeof(request));
-  want_bytes = 64;
-  len = dcm300_read(dcm300small, dcm300_circular(dcm300small), want_bytes);
-  if(len == want_bytes) fprintf(stderr, "[");
-  len = want_bytes = MAXBULK;
-  for(i = 0; i < expect_image && len == want_bytes; i += len)
+  if((dcm300->autoexposure || dcm300->whitebalance) && !dcm300->metered)
+    dcm300_meter(dcm300);
+  /* masters of the exposure and gains just set */
+  if(dcm300->calib)
+    calib_select(dcm300->calib, dcm300);
+  if(dcm300->defect)
+    defect_select(dcm300->defect, dcm300);
+  /* long exposure instead of an unstable long exposure value */
+  if(dcm300->stack)
   {
-    len = dcm300_read(dcm300small, dcm300_circular(dcm300small), want_bytes);
-    if(len == want_bytes) fprintf(stderr, ".");
+    stack_reset(dcm300->stack, dcm300->w * dcm300->h);
+    if(dcm300->stack->acc == NULL)
+      return -1;
   }
-  want_bytes = 256;
-  len = dcm300_read(dcm300small, dcm300_circular(dcm300small), want_bytes);
-  if(len == want_bytes) fprintf(stderr, "]");
-  
+
   /*
   ** We take the real size snapshot and we do
   ** on-the-fly demoaicing and writing the image to stdout
@@ -376,34 +725,82 @@ int dcm300_get_image(struct dcm300 *dcm300)
   ** parameters, this bug almost never happens (on my laptop).
   ** It often happens if the snapshot is taken at random times
   */
-  expect_image = dcm300->w * dcm300->h;
-  dcm300->bayer_from = 0; /* from 64th byte starts next block of bayer image raw data */
-  dcm300->bayer_read = -64; /* total raw bayer bytes read so far... */
-  dcm300->bayer_width = dcm300->w; /* one bayer horizontal line */
-  dcm300->bayer_end = dcm300->bayer_from + expect_image;
-
-  dcm300_create_request(dcm300, request);
-  dcm300_write(dcm300, (u8 *) request, sizeof(request));
-  
+  dcm300_settings(dcm300, s);
   dcm300_output_header(dcm300);
-  want_bytes = 64;
-  len = dcm300_read(dcm300, dcm300_circular(dcm300), want_bytes);
-  if(len == want_bytes) fprintf(stderr, "[");
-#if 0
-  fprintf(stderr, "image %dx%d\n", dcm300->w, dcm300->h);
-#endif
-  dcm300_output(dcm300, len);
-  len = want_bytes = MAXBULK;
-  for(i = 0; i < expect_image && len == want_bytes; i += len)
+  result = dcm300_session_capture(dcm300->session, s, dcm300_rows, dcm300);
+  if(dcm300_output_end(dcm300))
+    dcm300->output_error = 1;
+  dcm300_progress(dcm300, "\n");
+  p = dcm300_session_pipeline(dcm300->session);
+  if(verbose && p)
+    fprintf(stderr, "pipeline: %llu bulks, %llu dropped, queue max %d/%d, "
+      "output max %d/%d, %llu waits %.1f ms\n",
+      p->chunks, p->dropped_chunks, p->queue_max, p->queue_depth,
+      p->out_max, p->out_size, p->waits, p->wait_ns * 1e-6);
+  return result;
+}
+
+static volatile sig_atomic_t dcm300_preview_stop;
+
+static void dcm300_preview_signal(int sig)
+{
+  dcm300_preview_stop = 1;
+}
+
+/* live view: snapshot after snapshot on the open camera,
+** frames follow each other on the output (PNM, or MJPEG
+** with a .jpg output). Only the first frame is warmed up,
+** auto exposure and white balance then follow the
+** metered frames.
+** frames 0 runs until interrupted or the reader goes away.
+** Achieved frame rate is printed every second
+*/
+int dcm300_preview(struct dcm300 *dcm300, int frames)
+{
+  u64 t0, t, last;
+  int n, last_n = 0, result = 0;
+  int quiet = dcm300->quiet, metered = dcm300->metered;
+
+  dcm300_preview_stop = 0;
+  signal(SIGINT, dcm300_preview_signal);
+  signal(SIGPIPE, SIG_IGN);
+  /* progress marks would cost more than a small frame */
+  dcm300->quiet = 1;
+  t0 = last = dcm300_ns();
+  for(n = 0; (frames == 0 || n < frames) && !dcm300_preview_stop; )
   {
-    len = dcm300_read(dcm300, dcm300_circular(dcm300), want_bytes);
-    if(len == want_bytes) fprintf(stderr, ".");
-    dcm300_output(dcm300, len);
+    /* camera unplugged or stopped streaming */
+    if(dcm300_get_image(dcm300) < 0)
+    {
+      fprintf(stderr, "preview: camera read failed\n");
+      result = -1;
+      break;
+    }
+    /* viewer went away */
+    if(dcm300->output_error)
+      break;
+    if(dcm300->autoexposure || dcm300->whitebalance)
+    {
+      dcm300_meter_adjust(dcm300);
+      dcm300->metered = 1;
+    }
+    n++;
+    t = dcm300_ns();
+    if(!quiet && t - last >= 1000000000ULL)
+    {
+      fprintf(stderr, "preview %dx%d: %.1f fps\n",
+        dcm300->w / dcm300_scale(dcm300), dcm300->h / dcm300_scale(dcm300),
+        (n - last_n) * 1e9 / (t - last));
+      last = t;
+      last_n = n;
+    }
   }
-  want_bytes = 256;
-  len = dcm300_read(dcm300, dcm300_circular(dcm300), want_bytes);
-  if(len == want_bytes) fprintf(stderr, "]");
-  dcm300_output(dcm300, len);
-  fprintf(stderr, "\n");
-  return 0;
+  t = dcm300_ns();
+  if(!quiet)
+    fprintf(stderr, "preview: %d frames in %.2f s, %.1f fps\n",
+      n, (t - t0) * 1e-9, t > t0 ? n * 1e9 / (t - t0) : 0.0);
+  signal(SIGINT, SIG_DFL);
+  dcm300->quiet = quiet;
+  dcm300->metered = metered;
+  return n > 0 ? result : -1;
 }
@@ -2,12 +2,23 @@
 #define DCM300_H
 #include <usb.h>
 #include "binarytype.h"
+#include "libdcm300.h"
+#include "bayer.h"
+#include "ring.h"
+#include "demosaic.h"
+#include "usbfs.h"
+#include "trace.h"
+#include "stats.h"
+#include "encode.h"
+#include "overlay.h"
+#include "meter.h"
+#include "stack.h"
+#include "calib.h"
+#include "defect.h"
 
 /* struct for exchanging messages with dcm300 adapter */
 
 #define MAXBULK 16384
-#define BAYER_CIRCULAR 32768
-#define RGB_MAX (3*BAYER_CIRCULAR/8)
 
 /* commands that can be sent to dcm300 */
 
@@ -60,49 +71,44 @@ struct bt_security {
 struct dcm300 {
   int fd; /* raw file open descriptor */
   usb_dev_handle *usb_dev_handle; /* open libusb device */
+  int usbfs; /* open usbfs device node or -1 if libusb handle is used */
+  int urbs; /* 0-synchronous libusb bulk reads >0-number of queued URBs */
+  int bulk; /* bytes per bulk transfer of image data */
+  struct usbfs_queue *queue; /* asynchronous URB queue */
   char *name; /* device name or raw image filename */
-  int simulation; /* 0-use real hardware 1-simulation using raw file */
+  int simulation; /* 0-use real hardware 1-simulation using raw file 2-replay of a trace */
+  char *record_name; /* record USB transfers to this trace file or NULL */
+  struct trace *record; /* trace being recorded */
+  struct trace *replay; /* trace being replayed in simulation 2 */
+  struct stats *stats; /* timing histograms or NULL */
+  u64 t_startup; /* dcm300_ns() at program start until the first bulk is read, or 0 */
   u16 x, y; /* offset from where to grab the image5~ */
   u16 w, h; /* x-width, y-height of the image */
   u16 exposure;
+  int autoexposure; /* 1-meter and set exposure before the snapshot */
+  int whitebalance; /* 1-meter and set red and blue gain before the snapshot */
+  int wb_mode; /* METER_GRAY_WORLD or METER_BRIGHTEST */
+  struct meter *meter; /* histograms of the current frame or NULL */
+  int metered; /* 1-frames themselves are metered (preview), no tiny frames */
   s8 red, green, blue; /* RGB gain */
   int raw; /* 0-downscale 1-output raw bayer data */
+  int demosaic; /* DEMOSAIC_BIN half resolution or full resolution method */
+  int bin; /* DEMOSAIC_BIN block size: 2, or 4 and 8 for preview */
+  int threads; /* worker threads of full resolution demosaic */
+  struct dcm300_session *session; /* capture on the transport above */
+  int warming; /* 1-warm-up or metering frame is being read */
+  u64 bytes; /* read in frames, without warm-up and metering */
+  int quiet; /* 1-don't print progress to stderr */
   int output; /* output file descriptor */
-  int bayer_from; /* from this byte of output start bayer data */
-  int bayer_read; /* total bytes of raw bayer stream read so far, index to bayer circular */
-  int bayer_end; /* end of bayer data */
-  int bayer_width; /* how many bytes has one RGGB line */
-  u8 bayer_circular[BAYER_CIRCULAR]; /* circular buffer for bayer conversion on-the-fly */
-};
-
-/* request for dcm300 snapshot packet 
-*/
-struct dcm300_request {
-  unsigned char unknown1a;      /* 2c */
-  unsigned char unknown1a_0[1]; /* 00 */
-  unsigned char unknown1b;      /* 0e */
-  unsigned char unknown1b_0[1]; /* 00 */
-  unsigned char unknown1c;      /* 01 */
-  unsigned char unknown1_0[7];  /* 00 ... */
-  unsigned char unknown2;       /* 20 */
-  unsigned char unknown2_0[1];  /* 00 ... */
-  unsigned char gamma;          /* maybe gamma maybe not, values seen: bf,d6,da,b0,e1 */
-  unsigned char unknown3;       /* 05 */
-  unsigned char resolution_y_lo, resolution_y_hi;
-  unsigned char unknown3_0[2];  /* 00 ... */
-  unsigned char resolution_x_lo, resolution_x_hi;
-  unsigned char unknown4_0[2];  /* 00 ... */
-  unsigned char offset_x_lo, offset_x_hi;
-  unsigned char offset_x_hlo, offset_x_hhi;
-  // unsigned char unknown5_0[2];  /* 00 ... */
-  unsigned char offset_y_lo, offset_y_hi;
-  unsigned char unknown6_0[2];  /* 00 ... */
-  unsigned char exposure_lo, exposure_hi; /* lo,hi = exp + 20 */
-  unsigned char unknown7_0[2];  /* 00 ... */
-  char gain_red, gain_green, gain_blue;
-  unsigned char unknown8_0[1];
-  unsigned char unknown9;       /* 02 */
-  unsigned char unknown9_0[23]; /* 00 ... */
+  struct encoder *encoder; /* JPEG or PNG encoder of the output, NULL for PNM */
+  struct overlay *overlay; /* scale bar appended below the image or NULL */
+  int rgb_out; /* bytes of current image passed to dcm300_output_rgb() */
+  int output_error; /* 1-writing current image failed */
+  int ring_size; /* requested size of the session's ring, grown to fit bulks and a block of rows */
+  struct stack *stack; /* frames added up per snapshot or NULL */
+  struct calib *calib; /* dark and flat correction or NULL */
+  struct defect *defect; /* hot and dead pixels corrected or NULL */
+  int pipeline_depth; /* 0-serial >0-bulks queued between reader and conversion thread */
 };
 
 
@@ -125,14 +131,25 @@ extern int bt_stopbits2int[];
 extern int fd;
 extern char *device;
 #endif
-extern struct dcm300 *dcm300;
 extern int verbose;
 
+int dcm300_geometry(struct dcm300 *dcm300, char *spec);
 int dcm300_open(struct dcm300 *dcm300);
 int dcm300_close(struct dcm300 *dcm300);
 int dcm300_read(struct dcm300 *dcm300, u8 *buffer, int bytes);
 int dcm300_write(struct dcm300 *dcm300, u8 *buffer, int bytes);
+int dcm300_expect(struct dcm300 *dcm300, int image_bytes);
+void dcm300_progress(struct dcm300 *dcm300, char *mark);
+int dcm300_output_write(struct dcm300 *dcm300, void *data, int len);
+int dcm300_output_rgb(struct dcm300 *dcm300, u8 *rgb, int len);
+int dcm300_output_header(struct dcm300 *dcm300);
+int dcm300_output_end(struct dcm300 *dcm300);
+int dcm300_warmup(struct dcm300 *dcm300);
+int dcm300_meter(struct dcm300 *dcm300);
+int dcm300_meter_adjust(struct dcm300 *dcm300);
 int dcm300_get_image(struct dcm300 *dcm300);
+int dcm300_scale(struct dcm300 *dcm300);
+int dcm300_preview(struct dcm300 *dcm300, int frames);
 
 int bt_close(struct dcm300 *bt);
 
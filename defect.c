@@ -0,0 +1,252 @@
+/* defect.c
+**
+** Hot and dead pixel map, detected from calibration
+** masters, corrected from same color neighbours
+** while the rows stream in
+**
+** License: GPL
+**
+*/
+#include "dcm300.h"
+#include "defect.h"
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+
+/* map DEFECT_FILE of the calibration directory, NULL if none */
+struct defect *defect_open(char *dir)
+{
+  char name[PATH_MAX];
+  struct defect_header *h;
+  struct defect *d;
+  struct stat st;
+  int fd;
+
+  snprintf(name, sizeof(name), "%s/%s", dir, DEFECT_FILE);
+  fd = open(name, O_RDONLY);
+  if(fd < 0)
+    return NULL;
+  d = calloc(1, sizeof(*d));
+  if(d == NULL || fstat(fd, &st) < 0 || st.st_size < (off_t) sizeof(*h))
+  {
+    close(fd);
+    free(d);
+    return NULL;
+  }
+  d->len = st.st_size;
+  d->map = mmap(NULL, d->len, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if(d->map == MAP_FAILED)
+  {
+    free(d);
+    return NULL;
+  }
+  h = d->map;
+  if(memcmp(h->magic, DEFECT_MAGIC, sizeof(h->magic)) != 0
+  || h->version != DEFECT_VERSION || d->len < sizeof(*h) + h->count * sizeof(u32))
+  {
+    fprintf(stderr, "defects: bad file %s\n", name);
+    munmap(d->map, d->len);
+    free(d);
+    return NULL;
+  }
+  d->sensor = (const u32 *) (h + 1);
+  d->count = h->count;
+  d->local = malloc((d->count + 1) * sizeof(*d->local));
+  if(d->local == NULL)
+  {
+    defect_close(d);
+    return NULL;
+  }
+  if(verbose)
+    fprintf(stderr, "defects: %d pixels in %s\n", d->count, name);
+  return d;
+}
+
+void defect_close(struct defect *d)
+{
+  if(d == NULL)
+    return;
+  munmap(d->map, d->len);
+  free(d->local);
+  free(d);
+}
+
+/* defects inside the window of the next snapshot,
+** as positions in its image, still sorted
+*/
+void defect_select(struct defect *d, struct dcm300 *dcm300)
+{
+  u32 x, y;
+  int i;
+
+  d->nlocal = 0;
+  d->w = dcm300->w;
+  for(i = 0; i < d->count; i++)
+  {
+    y = d->sensor[i] / DCM300_WIDTH;
+    x = d->sensor[i] % DCM300_WIDTH;
+    if(x >= dcm300->x && x < (u32) dcm300->x + dcm300->w
+    && y >= dcm300->y && y < (u32) dcm300->y + dcm300->h)
+      d->local[d->nlocal++] = (y - dcm300->y) * dcm300->w + x - dcm300->x;
+  }
+  d->next = 0;
+}
+
+/* every frame of a stack is corrected */
+void defect_start(struct defect *d)
+{
+  d->next = 0;
+}
+
+/* replace defects among the len bytes arrived at ring
+** position pos by the mean of the same color pixels left
+** and right. Right one is used only if it has arrived,
+** so a defect never waits for the next transfer.
+** Costs one step per defect, not per pixel
+*/
+void defect_apply(struct defect *d, struct ring *ring, int pos, int len)
+{
+  int stop = pos + len;
+  int p, col, v, n;
+
+  for(; d->next < d->nlocal && (int) d->local[d->next] < stop; d->next++)
+  {
+    p = d->local[d->next];
+    if(p < pos)
+      continue;
+    col = p % d->w;
+    v = n = 0;
+    if(col >= 2)
+    {
+      v += *ring_at(ring, p - 2);
+      n++;
+    }
+    if(col + 2 < d->w && p + 2 < stop)
+    {
+      v += *ring_at(ring, p + 2);
+      n++;
+    }
+    if(n)
+      *ring_at(ring, p) = (v + n / 2) / n;
+  }
+}
+
+static int defect_compare(const void *a, const void *b)
+{
+  u32 x = *(const u32 *) a, y = *(const u32 *) b;
+
+  return x < y ? -1 : x > y;
+}
+
+/* add defects seen in the dark and flat masters of the
+** current setting to DEFECT_FILE, keeping the ones there
+*/
+int defect_detect(struct dcm300 *dcm300, char *dir)
+{
+  struct calib *c;
+  struct calib_header *h;
+  struct defect *old;
+  struct defect_header dh;
+  char name[PATH_MAX], tmp[PATH_MAX + 8];
+  u64 sum[4], count[4];
+  u32 *list, x, y, k, g;
+  int i, n = 0, max, fd, masters = 0;
+
+  c = calib_create(dir);
+  old = defect_open(dir);
+  if(c == NULL)
+    return -1;
+  /* masters of this setting that cover the -G window */
+  calib_select(c, dcm300);
+  max = (old ? old->count : 0) + 2 * DCM300_WIDTH * DCM300_HEIGHT / 64;
+  list = malloc(max * sizeof(*list));
+  if(list == NULL)
+  {
+    calib_destroy(c);
+    defect_close(old);
+    return -1;
+  }
+  for(i = 0; old && i < old->count; i++)
+    list[n++] = old->sensor[i];
+
+  /* hot: dark level well above the mean of its color */
+  if((h = c->dark.header) != NULL)
+  {
+    masters++;
+    memset(sum, 0, sizeof(sum));
+    memset(count, 0, sizeof(count));
+    for(y = 0; y < h->h; y++)
+      for(x = 0; x < h->w; x++)
+      {
+        k = ((h->y + y) & 1) * 2 + ((h->x + x) & 1);
+        sum[k] += c->dark.dark[y * h->w + x];
+        count[k]++;
+      }
+    for(y = 0; y < h->h; y++)
+      for(x = 0; x < h->w && n < max; x++)
+      {
+        k = ((h->y + y) & 1) * 2 + ((h->x + x) & 1);
+        if(c->dark.dark[y * h->w + x] * count[k] > sum[k] + DEFECT_HOT * count[k])
+          list[n++] = (h->y + y) * DCM300_WIDTH + h->x + x;
+      }
+  }
+  /* dead or stuck: response off by DEFECT_WEAK from its color */
+  if((h = c->flat.header) != NULL)
+  {
+    masters++;
+    for(y = 0; y < h->h; y++)
+      for(x = 0; x < h->w && n < max; x++)
+      {
+        g = c->flat.gain[y * h->w + x];
+        if(g > CALIB_ONE * DEFECT_WEAK || g < CALIB_ONE / DEFECT_WEAK)
+          list[n++] = (h->y + y) * DCM300_WIDTH + h->x + x;
+      }
+  }
+  calib_destroy(c);
+  defect_close(old);
+  if(masters == 0)
+  {
+    fprintf(stderr, "defects: no dark or flat master of this setting in %s\n", dir);
+    free(list);
+    return -1;
+  }
+
+  /* sorted, without duplicates */
+  qsort(list, n, sizeof(*list), defect_compare);
+  for(i = k = 0; i < n; i++)
+    if(k == 0 || list[i] != list[k - 1])
+      list[k++] = list[i];
+  n = k;
+
+  memcpy(dh.magic, DEFECT_MAGIC, sizeof(dh.magic));
+  dh.version = DEFECT_VERSION;
+  dh.count = n;
+  snprintf(name, sizeof(name), "%s/%s", dir, DEFECT_FILE);
+  snprintf(tmp, sizeof(tmp), "%s.tmp", name);
+  fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if(fd < 0)
+  {
+    perror(tmp);
+    free(list);
+    return -1;
+  }
+  if(write(fd, &dh, sizeof(dh)) != sizeof(dh)
+  || write(fd, list, n * sizeof(*list)) != (ssize_t) (n * sizeof(*list))
+  || close(fd) < 0 || rename(tmp, name) < 0)
+  {
+    perror(name);
+    unlink(tmp);
+    free(list);
+    return -1;
+  }
+  free(list);
+  if(verbose)
+    fprintf(stderr, "defects: %d pixels in %s\n", n, name);
+  return 0;
+}
@@ -0,0 +1,47 @@
+#ifndef DEFECT_H
+#define DEFECT_H
+#include <stddef.h>
+#include "binarytype.h"
+#include "ring.h"
+
+/* hot, dead and stuck pixels of the sensor.
+** Detected from the dark and flat masters of the
+** calibration directory into its DEFECT_FILE:
+** defect_header then count sorted u32 sensor positions
+** y*DCM300_WIDTH+x. Integers are in host byte order.
+*/
+
+#define DEFECT_MAGIC   "DCM300DF"
+#define DEFECT_VERSION 1
+#define DEFECT_FILE    "defects.map"
+
+#define DEFECT_HOT  24 /* dark level above mean of its color */
+#define DEFECT_WEAK 2  /* flat response off by this factor */
+
+struct defect_header {
+  char magic[8]; /* DEFECT_MAGIC */
+  u32 version; /* DEFECT_VERSION */
+  u32 count;
+};
+
+struct defect {
+  void *map; /* whole file */
+  size_t len;
+  const u32 *sensor; /* sorted sensor positions */
+  int count;
+  u32 *local; /* image positions of defects inside the window */
+  int nlocal;
+  int next; /* first defect not yet corrected in the current frame */
+  int w; /* window width */
+};
+
+struct dcm300;
+
+struct defect *defect_open(char *dir);
+void defect_select(struct defect *d, struct dcm300 *dcm300);
+void defect_start(struct defect *d);
+void defect_apply(struct defect *d, struct ring *ring, int pos, int len);
+int defect_detect(struct dcm300 *dcm300, char *dir);
+void defect_close(struct defect *d);
+
+#endif
@@ -0,0 +1,310 @@
+/* demosaic.c
+**
+** Streaming full resolution RGGB demosaic
+** bilinear and Malvar-He-Cutler (gradient corrected)
+** interpolation, horizontal strips on worker threads
+**
+** License: GPL
+**
+*/
+#include "demosaic.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DEMOSAIC_MAX_THREADS 64
+
+struct demosaic_strip {
+  struct demosaic *d;
+  int y0, y1; /* output rows of this strip */
+  pthread_t thread;
+};
+
+int demosaic_method(char *name)
+{
+  if(strcmp(name, "bilinear") == 0)
+    return DEMOSAIC_BILINEAR;
+  if(strcmp(name, "mhc") == 0)
+    return DEMOSAIC_MHC;
+  return DEMOSAIC_BIN;
+}
+
+/* line buffer row r, rows and columns outside
+** the image are mirrored keeping the bayer phase
+*/
+static inline const u8 *demosaic_line(struct demosaic *d, int r)
+{
+  if(r < 0)
+    r = -r;
+  if(r >= d->height)
+    r = 2*(d->height - 1) - r;
+  return d->lines + (r % d->nlines) * d->stride + 2;
+}
+
+static void demosaic_bilinear_row(struct demosaic *d, int y, u8 *out)
+{
+  const u8 *n = demosaic_line(d, y - 1);
+  const u8 *c = demosaic_line(d, y);
+  const u8 *s = demosaic_line(d, y + 1);
+  int x;
+
+  if((y & 1) == 0)
+    for(x = 0; x < d->width; x += 2, out += 6)
+    {
+      /* R */
+      out[0] = c[x];
+      out[1] = (n[x] + s[x] + c[x-1] + c[x+1] + 2) >> 2;
+      out[2] = (n[x-1] + n[x+1] + s[x-1] + s[x+1] + 2) >> 2;
+      /* G on red row */
+      out[3] = (c[x] + c[x+2] + 1) >> 1;
+      out[4] = c[x+1];
+      out[5] = (n[x+1] + s[x+1] + 1) >> 1;
+    }
+  else
+    for(x = 0; x < d->width; x += 2, out += 6)
+    {
+      /* G on blue row */
+      out[0] = (n[x] + s[x] + 1) >> 1;
+      out[1] = c[x];
+      out[2] = (c[x-1] + c[x+1] + 1) >> 1;
+      /* B */
+      out[3] = (n[x] + n[x+2] + s[x] + s[x+2] + 2) >> 2;
+      out[4] = (n[x+1] + s[x+1] + c[x] + c[x+2] + 2) >> 2;
+      out[5] = c[x+1];
+    }
+}
+
+static inline u8 demosaic_clip16(int v)
+{
+  v = (v + 8) >> 4;
+  return v < 0 ? 0 : v > 255 ? 255 : v;
+}
+
+/* Malvar-He-Cutler 5x5 filters, coefficients scaled to /16
+** G     green at red or blue
+** ROW   color of left/right neighbours at green
+** COL   color of up/down neighbours at green
+** OPP   blue at red or red at blue
+*/
+#define MHC_DIAG(x) (n[x-1] + n[x+1] + s[x-1] + s[x+1])
+#define MHC_G(x)   demosaic_clip16(8*c[x] + 4*(n[x] + s[x] + c[x-1] + c[x+1]) \
+                     - 2*(n2[x] + s2[x] + c[x-2] + c[x+2]))
+#define MHC_ROW(x) demosaic_clip16(10*c[x] + 8*(c[x-1] + c[x+1]) - 2*(c[x-2] + c[x+2]) \
+                     - 2*MHC_DIAG(x) + n2[x] + s2[x])
+#define MHC_COL(x) demosaic_clip16(10*c[x] + 8*(n[x] + s[x]) - 2*(n2[x] + s2[x]) \
+                     - 2*MHC_DIAG(x) + c[x-2] + c[x+2])
+#define MHC_OPP(x) demosaic_clip16(12*c[x] + 4*MHC_DIAG(x) \
+                     - 3*(n2[x] + s2[x] + c[x-2] + c[x+2]))
+
+static void demosaic_mhc_row(struct demosaic *d, int y, u8 *out)
+{
+  const u8 *n2 = demosaic_line(d, y - 2);
+  const u8 *n  = demosaic_line(d, y - 1);
+  const u8 *c  = demosaic_line(d, y);
+  const u8 *s  = demosaic_line(d, y + 1);
+  const u8 *s2 = demosaic_line(d, y + 2);
+  int x;
+
+  if((y & 1) == 0)
+    for(x = 0; x < d->width; x += 2, out += 6)
+    {
+      /* R */
+      out[0] = c[x];
+      out[1] = MHC_G(x);
+      out[2] = MHC_OPP(x);
+      /* G on red row */
+      out[3] = MHC_ROW(x+1);
+      out[4] = c[x+1];
+      out[5] = MHC_COL(x+1);
+    }
+  else
+    for(x = 0; x < d->width; x += 2, out += 6)
+    {
+      /* G on blue row */
+      out[0] = MHC_COL(x);
+      out[1] = c[x];
+      out[2] = MHC_ROW(x);
+      /* B */
+      out[3] = MHC_OPP(x+1);
+      out[4] = MHC_G(x+1);
+      out[5] = c[x+1];
+    }
+}
+
+static void *demosaic_strip_run(void *arg)
+{
+  struct demosaic_strip *strip = arg;
+  struct demosaic *d = strip->d;
+  int y;
+
+  for(y = strip->y0; y < strip->y1; y++)
+  {
+    u8 *out = d->rgb + (y - d->rows_out) * 3 * d->width;
+    if(d->method == DEMOSAIC_MHC)
+      demosaic_mhc_row(d, y, out);
+    else
+      demosaic_bilinear_row(d, y, out);
+  }
+  return NULL;
+}
+
+/* worker of strip 1..workers, runs its strip of every
+** batch until the demosaic is destroyed
+*/
+static void *demosaic_worker(void *arg)
+{
+  struct demosaic_strip *strip = arg;
+  struct demosaic *d = strip->d;
+  int generation = 0;
+
+  pthread_mutex_lock(&d->lock);
+  for(;;)
+  {
+    while(d->generation == generation && !d->stop)
+      pthread_cond_wait(&d->go, &d->lock);
+    if(d->stop)
+      break;
+    generation = d->generation;
+    pthread_mutex_unlock(&d->lock);
+    demosaic_strip_run(strip);
+    pthread_mutex_lock(&d->lock);
+    if(--d->pending == 0)
+      pthread_cond_signal(&d->done);
+  }
+  pthread_mutex_unlock(&d->lock);
+  return NULL;
+}
+
+/* demosaic rows from rows_out up to end and deliver them */
+static int demosaic_batch(struct demosaic *d, int end)
+{
+  int i, n = d->threads, rows = end - d->rows_out;
+
+  for(i = 0; i < n; i++)
+  {
+    d->strip[i].y0 = d->rows_out + rows * i / n;
+    d->strip[i].y1 = d->rows_out + rows * (i + 1) / n;
+  }
+  if(d->workers > 0)
+  {
+    pthread_mutex_lock(&d->lock);
+    d->pending = d->workers;
+    d->generation++;
+    pthread_cond_broadcast(&d->go);
+    pthread_mutex_unlock(&d->lock);
+  }
+  /* calling thread takes the first strip and those without worker */
+  demosaic_strip_run(&d->strip[0]);
+  for(i = d->workers + 1; i < n; i++)
+    demosaic_strip_run(&d->strip[i]);
+  if(d->workers > 0)
+  {
+    pthread_mutex_lock(&d->lock);
+    while(d->pending > 0)
+      pthread_cond_wait(&d->done, &d->lock);
+    pthread_mutex_unlock(&d->lock);
+  }
+
+  d->rows_out = end;
+  return d->cbfunc(d->param, rows * 3 * d->width, d->rgb);
+}
+
+struct demosaic *demosaic_create(int method, int width, int height, int threads,
+                                 demosaic_callback cbfunc, void *param)
+{
+  struct demosaic *d;
+  int i;
+
+  d = calloc(1, sizeof(*d));
+  if(d == NULL)
+    return NULL;
+  pthread_mutex_init(&d->lock, NULL);
+  pthread_cond_init(&d->go, NULL);
+  pthread_cond_init(&d->done, NULL);
+  if(threads < 1)
+    threads = 1;
+  if(threads > DEMOSAIC_MAX_THREADS)
+    threads = DEMOSAIC_MAX_THREADS;
+  d->method = method;
+  d->width = width;
+  d->height = height;
+  d->threads = threads;
+  d->batch = threads * DEMOSAIC_STRIP;
+  d->stride = width + 4;
+  /* batch plus 2 rows above and 2 below */
+  d->nlines = d->batch + 4;
+  d->lines = malloc(d->nlines * d->stride);
+  d->rgb = malloc(d->batch * 3 * width);
+  d->strip = calloc(threads, sizeof(*d->strip));
+  d->cbfunc = cbfunc;
+  d->param = param;
+  if(d->lines == NULL || d->rgb == NULL || d->strip == NULL)
+  {
+    demosaic_destroy(d);
+    return NULL;
+  }
+  for(i = 0; i < threads; i++)
+    d->strip[i].d = d;
+  /* workers live as long as the demosaic, not a batch.
+  ** Strips of workers that didn't start run on the caller
+  */
+  for(i = 1; i < threads; i++)
+  {
+    if(pthread_create(&d->strip[i].thread, NULL, demosaic_worker, &d->strip[i]))
+      break;
+    d->workers++;
+  }
+  return d;
+}
+
+/* add next bayer row, demosaic and deliver
+** a batch as soon as rows below it have arrived
+*/
+int demosaic_push(struct demosaic *d, const u8 *row)
+{
+  u8 *line;
+  int end, w = d->width;
+
+  if(d->rows_in >= d->height)
+    return 0;
+  line = d->lines + (d->rows_in % d->nlines) * d->stride + 2;
+  memcpy(line, row, w);
+  line[-1] = line[1];
+  line[-2] = line[2];
+  line[w] = line[w - 2];
+  line[w + 1] = line[w - 3];
+  d->rows_in++;
+
+  while(d->rows_out < d->height)
+  {
+    end = d->rows_out + d->batch;
+    if(end > d->height)
+      end = d->height;
+    if(d->rows_in < end + 2 && d->rows_in < d->height)
+      break;
+    if(demosaic_batch(d, end) < 0)
+      return -1;
+  }
+  return 0;
+}
+
+void demosaic_destroy(struct demosaic *d)
+{
+  int i;
+
+  if(d == NULL)
+    return;
+  pthread_mutex_lock(&d->lock);
+  d->stop = 1;
+  pthread_cond_broadcast(&d->go);
+  pthread_mutex_unlock(&d->lock);
+  for(i = 1; i <= d->workers; i++)
+    pthread_join(d->strip[i].thread, NULL);
+  pthread_mutex_destroy(&d->lock);
+  pthread_cond_destroy(&d->go);
+  pthread_cond_destroy(&d->done);
+  free(d->strip);
+  free(d->lines);
+  free(d->rgb);
+  free(d);
+}
@@ -0,0 +1,54 @@
+#ifndef DEMOSAIC_H
+#define DEMOSAIC_H
+#include <pthread.h>
+#include "binarytype.h"
+
+/* demosaic methods */
+#define DEMOSAIC_BIN      0 /* 2x2 binning, half resolution */
+#define DEMOSAIC_BILINEAR 1 /* full resolution, bilinear */
+#define DEMOSAIC_MHC      2 /* full resolution, Malvar-He-Cutler gradient corrected */
+
+#define DEMOSAIC_STRIP 16 /* output rows per worker thread and batch */
+
+/* receives completed RGB rows */
+typedef int (*demosaic_callback) (void *param, unsigned bytes, void *data);
+
+struct demosaic_strip;
+
+/* streaming full resolution demosaic of RGGB rows.
+** Only a batch of threads*DEMOSAIC_STRIP rows plus 2 rows
+** above and below is kept. Each batch is split into
+** horizontal strips, one per thread: the pushing thread
+** takes the first, workers started with the demosaic
+** take the others and wait for the next batch
+*/
+struct demosaic {
+  int method; /* DEMOSAIC_BILINEAR or DEMOSAIC_MHC */
+  int width, height; /* bayer pixels */
+  int threads; /* worker threads per batch */
+  int batch; /* output rows per batch */
+  int stride; /* bytes of a line buffer row, 2 pixels padding at each side */
+  int nlines; /* rows in line buffer */
+  u8 *lines; /* circular line buffer, row r at slot r % nlines */
+  u8 *rgb; /* RGB rows of one batch */
+  int rows_in; /* bayer rows pushed so far */
+  int rows_out; /* RGB rows delivered so far */
+  demosaic_callback cbfunc;
+  void *param;
+  struct demosaic_strip *strip; /* threads strips, workers run 1..workers */
+  int workers; /* worker threads running */
+  pthread_mutex_t lock;
+  pthread_cond_t go; /* new batch or stop for the workers */
+  pthread_cond_t done; /* last worker finished its strip */
+  int generation; /* batches handed to the workers */
+  int pending; /* workers still on the current batch */
+  int stop; /* 1-workers exit */
+};
+
+int demosaic_method(char *name);
+struct demosaic *demosaic_create(int method, int width, int height, int threads,
+                                 demosaic_callback cbfunc, void *param);
+int demosaic_push(struct demosaic *d, const u8 *row);
+void demosaic_destroy(struct demosaic *d);
+
+#endif
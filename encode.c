@@ -0,0 +1,297 @@
+/* encode.c
+**
+** JPEG (libjpeg-turbo) and PNG (libpng) output
+** encoded row by row while the image streams in
+**
+** License: GPL
+**
+*/
+#include "encode.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <setjmp.h>
+#include <jpeglib.h>
+#include <png.h>
+
+#define ENCODE_PNG_LEVEL 3 /* zlib level, higher ones cost much more time than they save */
+
+struct encoder {
+  int format; /* ENCODE_JPEG or ENCODE_PNG */
+  int quality; /* JPEG quality 1-100 */
+  int fd; /* compressed data goes here */
+  int width, height; /* pixels */
+  int stride; /* bytes of RGB row */
+  int rows; /* rows compressed so far */
+  int fill; /* bytes of incomplete row */
+  int started; /* 1-between begin and end */
+  int error; /* 1-library or write error, rest of image is discarded */
+  u8 *row; /* incomplete row */
+  u8 *buffer; /* ENCODE_BUFFER bytes of compressed data */
+  jmp_buf jmp; /* libjpeg errors return here */
+  struct jpeg_compress_struct jpeg;
+  struct jpeg_error_mgr jerr;
+  struct jpeg_destination_mgr dest;
+  png_structp png;
+  png_infop info;
+};
+
+/* format by file name extension */
+int encode_format(char *filename)
+{
+  char *ext = strrchr(filename, '.');
+
+  if(ext == NULL)
+    return ENCODE_PNM;
+  if(strcasecmp(ext, ".jpg") == 0 || strcasecmp(ext, ".jpeg") == 0)
+    return ENCODE_JPEG;
+  if(strcasecmp(ext, ".png") == 0)
+    return ENCODE_PNG;
+  return ENCODE_PNM;
+}
+
+static void encode_write_fd(struct encoder *enc, const u8 *data, int len)
+{
+  int n;
+
+  while(len > 0 && !enc->error)
+  {
+    n = write(enc->fd, data, len);
+    if(n <= 0)
+    {
+      enc->error = 1;
+      break;
+    }
+    data += n;
+    len -= n;
+  }
+}
+
+/* libjpeg destination writing to fd */
+static void encode_jpeg_init(j_compress_ptr cinfo)
+{
+  struct encoder *enc = cinfo->client_data;
+
+  enc->dest.next_output_byte = enc->buffer;
+  enc->dest.free_in_buffer = ENCODE_BUFFER;
+}
+
+static boolean encode_jpeg_empty(j_compress_ptr cinfo)
+{
+  struct encoder *enc = cinfo->client_data;
+
+  encode_write_fd(enc, enc->buffer, ENCODE_BUFFER);
+  enc->dest.next_output_byte = enc->buffer;
+  enc->dest.free_in_buffer = ENCODE_BUFFER;
+  return TRUE;
+}
+
+static void encode_jpeg_term(j_compress_ptr cinfo)
+{
+  struct encoder *enc = cinfo->client_data;
+
+  encode_write_fd(enc, enc->buffer, ENCODE_BUFFER - enc->dest.free_in_buffer);
+}
+
+/* libjpeg would exit() on error */
+static void encode_jpeg_error(j_common_ptr cinfo)
+{
+  struct encoder *enc = cinfo->client_data;
+
+  (*cinfo->err->output_message)(cinfo);
+  longjmp(enc->jmp, 1);
+}
+
+/* libpng output writing to fd */
+static void encode_png_write(png_structp png, png_bytep data, png_size_t len)
+{
+  encode_write_fd(png_get_io_ptr(png), data, len);
+}
+
+static void encode_png_flush(png_structp png)
+{
+}
+
+struct encoder *encode_create(int format, int quality)
+{
+  struct encoder *enc;
+
+  enc = calloc(1, sizeof(*enc));
+  if(enc == NULL)
+    return NULL;
+  enc->format = format;
+  enc->quality = quality < 1 ? 1 : quality > 100 ? 100 : quality;
+  enc->fd = -1;
+  enc->buffer = malloc(ENCODE_BUFFER);
+  if(enc->buffer == NULL)
+  {
+    free(enc);
+    return NULL;
+  }
+  return enc;
+}
+
+/* free library state of the current image */
+static void encode_release(struct encoder *enc)
+{
+  if(enc->format == ENCODE_JPEG && enc->started)
+    jpeg_destroy_compress(&enc->jpeg);
+  if(enc->png)
+    png_destroy_write_struct(&enc->png, &enc->info);
+  enc->png = NULL;
+  enc->info = NULL;
+  enc->started = 0;
+  free(enc->row);
+  enc->row = NULL;
+}
+
+/* start a new image, compressed data is written to fd */
+int encode_begin(struct encoder *enc, int fd, int width, int height)
+{
+  encode_release(enc);
+  enc->fd = fd;
+  enc->width = width;
+  enc->height = height;
+  enc->stride = 3 * width;
+  enc->rows = 0;
+  enc->fill = 0;
+  enc->error = 0;
+  enc->row = malloc(enc->stride);
+  if(enc->row == NULL)
+  {
+    enc->error = 1;
+    return -1;
+  }
+
+  if(enc->format == ENCODE_JPEG)
+  {
+    enc->jpeg.err = jpeg_std_error(&enc->jerr);
+    enc->jerr.error_exit = encode_jpeg_error;
+    enc->jpeg.client_data = enc;
+    enc->started = 1;
+    if(setjmp(enc->jmp))
+    {
+      enc->error = 1;
+      return -1;
+    }
+    jpeg_create_compress(&enc->jpeg);
+    enc->dest.init_destination = encode_jpeg_init;
+    enc->dest.empty_output_buffer = encode_jpeg_empty;
+    enc->dest.term_destination = encode_jpeg_term;
+    enc->jpeg.dest = &enc->dest;
+    enc->jpeg.image_width = width;
+    enc->jpeg.image_height = height;
+    enc->jpeg.input_components = 3;
+    enc->jpeg.in_color_space = JCS_RGB;
+    jpeg_set_defaults(&enc->jpeg);
+    jpeg_set_quality(&enc->jpeg, enc->quality, TRUE);
+    jpeg_start_compress(&enc->jpeg, TRUE);
+    return 0;
+  }
+
+  enc->png = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+  if(enc->png)
+    enc->info = png_create_info_struct(enc->png);
+  if(enc->info == NULL)
+  {
+    enc->error = 1;
+    return -1;
+  }
+  enc->started = 1;
+  if(setjmp(png_jmpbuf(enc->png)))
+  {
+    enc->error = 1;
+    return -1;
+  }
+  png_set_write_fn(enc->png, enc, encode_png_write, encode_png_flush);
+  png_set_compression_level(enc->png, ENCODE_PNG_LEVEL);
+  png_set_compression_buffer_size(enc->png, ENCODE_BUFFER);
+  png_set_IHDR(enc->png, enc->info, width, height, 8, PNG_COLOR_TYPE_RGB,
+    PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+  png_write_info(enc->png, enc->info);
+  return 0;
+}
+
+/* compress one complete row, finish the file after the last one */
+static void encode_row(struct encoder *enc, const u8 *row)
+{
+  JSAMPROW rows[1];
+
+  if(enc->format == ENCODE_JPEG)
+  {
+    if(setjmp(enc->jmp))
+    {
+      enc->error = 1;
+      return;
+    }
+    rows[0] = (JSAMPROW) row;
+    jpeg_write_scanlines(&enc->jpeg, rows, 1);
+    if(++enc->rows == enc->height)
+      jpeg_finish_compress(&enc->jpeg);
+    return;
+  }
+  if(setjmp(png_jmpbuf(enc->png)))
+  {
+    enc->error = 1;
+    return;
+  }
+  png_write_row(enc->png, (png_const_bytep) row);
+  if(++enc->rows == enc->height)
+    png_write_end(enc->png, enc->info);
+}
+
+/* RGB bytes in pieces of any size. returns len, or -1 on error */
+int encode_write(struct encoder *enc, const u8 *data, int len)
+{
+  int n, done = 0;
+
+  while(done < len && enc->rows < enc->height && !enc->error)
+  {
+    /* whole rows straight from the caller's buffer */
+    if(enc->fill == 0 && len - done >= enc->stride)
+    {
+      encode_row(enc, data + done);
+      done += enc->stride;
+      continue;
+    }
+    n = enc->stride - enc->fill;
+    if(n > len - done)
+      n = len - done;
+    memcpy(enc->row + enc->fill, data + done, n);
+    enc->fill += n;
+    done += n;
+    if(enc->fill == enc->stride)
+    {
+      encode_row(enc, enc->row);
+      enc->fill = 0;
+    }
+  }
+  return enc->error ? -1 : len;
+}
+
+/* finish the image, rows that never arrived are black */
+int encode_end(struct encoder *enc)
+{
+  if(enc->row)
+  {
+    memset(enc->row + enc->fill, 0, enc->stride - enc->fill);
+    while(enc->rows < enc->height && !enc->error)
+    {
+      encode_row(enc, enc->row);
+      memset(enc->row, 0, enc->stride);
+    }
+  }
+  encode_release(enc);
+  return enc->error ? -1 : 0;
+}
+
+void encode_destroy(struct encoder *enc)
+{
+  if(enc == NULL)
+    return;
+  encode_release(enc);
+  free(enc->buffer);
+  free(enc);
+}
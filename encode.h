@@ -0,0 +1,26 @@
+#ifndef ENCODE_H
+#define ENCODE_H
+#include "binarytype.h"
+
+/* streaming JPEG and PNG encoder of RGB rows.
+** Rows may arrive in pieces of any size, each completed
+** row is compressed at once so the file is finished
+** right after the last row of the image
+*/
+
+#define ENCODE_PNM  0 /* no encoder, PNM header and raw RGB */
+#define ENCODE_JPEG 1
+#define ENCODE_PNG  2
+
+#define ENCODE_BUFFER 65536 /* bytes of compressed data per write() */
+
+struct encoder;
+
+int encode_format(char *filename);
+struct encoder *encode_create(int format, int quality);
+int encode_begin(struct encoder *enc, int fd, int width, int height);
+int encode_write(struct encoder *enc, const u8 *data, int len);
+int encode_end(struct encoder *enc);
+void encode_destroy(struct encoder *enc);
+
+#endif
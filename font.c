@@ -0,0 +1,588 @@
+/* font.c
+**
+** 16x32 bitmap font for the overlay, see font.h
+**
+** DejaVu fonts are derived from Bitstream Vera,
+** Copyright (c) 2003 by Bitstream, Inc.
+**
+*/
+#include "font.h"
+
+const u16 font_glyph[FONT_GLYPHS][FONT_HEIGHT] = {
+  /* ' ' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000 },
+  /* '!' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x01c0, 0x01c0, 0x01c0,
+    0x01c0, 0x01c0, 0x01c0, 0x01c0, 0x01c0, 0x01c0, 0x01c0, 0x01c0,
+    0x01c0, 0x01c0, 0x0000, 0x0000, 0x0000, 0x01c0, 0x01c0, 0x01c0,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000 },
+  /* '"' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0630, 0x0630, 0x0630,
+    0x0630, 0x0630, 0x0630, 0x0630, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000 },
+  /* '#' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x018c, 0x030c,
+    0x031c, 0x0318, 0x0318, 0x7fff, 0x7fff, 0x0630, 0x0630, 0x0c30,
+    0x0c60, 0xfffe, 0xfffe, 0x1860, 0x18c0, 0x18c0, 0x38c0, 0x31c0,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000 },
+  /* '$' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0080, 0x0080, 0x0080, 0x03f0,
+    0x0ff8, 0x1e88, 0x1c80, 0x1c80, 0x1c80, 0x1e80, 0x0f80, 0x07f0,
+    0x01f8, 0x00bc, 0x009c, 0x009c, 0x009c, 0x10b8, 0x1ff8, 0x0fe0,
+    0x0080, 0x0080, 0x0080, 0x0080, 0x0000, 0x0000, 0x0000, 0x0000 },
+  /* '%' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x3c00, 0x7e00, 0xe700,
+    0xc300, 0xc300, 0xe700, 0x7e0c, 0x3c38, 0x00e0, 0x0380, 0x0e00,
+    0x3878, 0x60fc, 0x01ce, 0x0186, 0x0186, 0x01ce, 0x00fc, 0x0078,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000 },
+  /* '&' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x07c0, 0x0fe0, 0x1e20,
+    0x1c00, 0x1c00, 0x1c00, 0x0e00, 0x0f00, 0x1f00, 0x3f83, 0x33c3,
+    0x71e3, 0x70e3, 0x70f6, 0x707e, 0x783c, 0x3c3e, 0x1fee, 0x0fcf,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000 },
+  /* '\'' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0180, 0x0180, 0x0180,
+    0x0180, 0x0180, 0x0180, 0x0180, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000 },
+  /* '(' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0060, 0x00c0, 0x00c0, 0x0180,
+    0x0180, 0x0380, 0x0380, 0x0700, 0x0700, 0x0700, 0x0700, 0x0700,
+    0x0700, 0x0700, 0x0700, 0x0700, 0x0380, 0x0380, 0x0180, 0x0180,
+    0x00c0, 0x00c0, 0x0060, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000 },
+  /* ')' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0600, 0x0300, 0x0300, 0x0180,
+    0x0180, 0x01c0, 0x01c0, 0x00c0, 0x00e0, 0x00e0, 0x00e0, 0x00e0,
+    0x00e0, 0x00e0, 0x00e0, 0x00c0, 0x01c0, 0x01c0, 0x0180, 0x0180,
+    0x0300, 0x0300, 0x0600, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000 },
+  /* '*' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0100, 0x0100, 0x3118,
+    0x3938, 0x0fe0, 0x0380, 0x0380, 0x0fe0, 0x3938, 0x3118, 0x0100,
+    0x0100, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000 },
+  /* '+' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0180, 0x0180, 0x0180, 0x0180, 0x0180, 0x0180, 0x7ffe,
+    0x7ffe, 0x0180, 0x0180, 0x0180, 0x0180, 0x0180, 0x0180, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000 },
+  /* ',' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0380, 0x0380, 0x0380, 0x0380,
+    0x0300, 0x0700, 0x0600, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000 },
+  /* '-' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x07f0, 0x07f0, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000 },
+  /* '.' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0380, 0x0380, 0x0380, 0x0380,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000 },
+  /* '/' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x001c, 0x0038, 0x0038,
+    0x0070, 0x0070, 0x00e0, 0x00e0, 0x01c0, 0x01c0, 0x0380, 0x0380,
+    0x0380, 0x0700, 0x0700, 0x0e00, 0x0e00, 0x1c00, 0x1c00, 0x3800,
+    0x3800, 0x7000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000 },
+  /* '0' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x03c0, 0x0ff0, 0x1e78,
+    0x1c38, 0x1c38, 0x381c, 0x381c, 0x381c, 0x3b9c, 0x3b9c, 0x3b9c,
+    0x381c, 0x381c, 0x381c, 0x1c38, 0x1c38, 0x1e78, 0x0ff0, 0x03c0,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000 },
+  /* '1' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x07c0, 0x1fc0, 0x19c0,
+    0x01c0, 0x01c0, 0x01c0, 0x01c0, 0x01c0, 0x01c0, 0x01c0, 0x01c0,
+    0x01c0, 0x01c0, 0x01c0, 0x01c0, 0x01c0, 0x01c0, 0x1ffc, 0x1ffc,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000 },
+  /* '2' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0fc0, 0x3ff0, 0x3878,
+    0x203c, 0x001c, 0x001c, 0x001c, 0x003c, 0x003c, 0x0078, 0x00f0,
+    0x01e0, 0x03c0, 0x0780, 0x0f00, 0x1e00, 0x3800, 0x3ffc, 0x3ffc,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000 },
+  /* '3' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x07e0, 0x1ff0, 0x1038,
+    0x001c, 0x001c, 0x001c, 0x001c, 0x0078, 0x07f0, 0x07e0, 0x0078,
+    0x003c, 0x001c, 0x001c, 0x001c, 0x003c, 0x2078, 0x3ff0, 0x0fc0,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000 },
+  /* '4' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x00e0, 0x01e0, 0x01e0,
+    0x03e0, 0x06e0, 0x06e0, 0x0ce0, 0x0ce0, 0x18e0, 0x30e0, 0x30e0,
+    0x60e0, 0x7ffc, 0x7ffc, 0x00e0, 0x00e0, 0x00e0, 0x00e0, 0x00e0,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000 },
+  /* '5' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x1ff8, 0x1ff8, 0x1c00,
+    0x1c00, 0x1c00, 0x1c00, 0x1fe0, 0x1ff0, 0x1078, 0x0038, 0x001c,
+    0x001c, 0x001c, 0x001c, 0x001c, 0x0038, 0x2078, 0x3ff0, 0x1fc0,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000 },
+  /* '6' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x03f0, 0x07f8, 0x0f08,
+    0x1c00, 0x1c00, 0x3800, 0x3800, 0x39e0, 0x3bf8, 0x3c38, 0x3c1c,
+    0x381c, 0x381c, 0x381c, 0x181c, 0x1c1c, 0x1c38, 0x0ff0, 0x03e0,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000 },
+  /* '7' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x3ffc, 0x3ffc, 0x0038,
+    0x0038, 0x0078, 0x0070, 0x0070, 0x00f0, 0x00e0, 0x00e0, 0x01c0,
+    0x01c0, 0x03c0, 0x0380, 0x0380, 0x0780, 0x0700, 0x0700, 0x0e00,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000 },
+  /* '8' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x07e0, 0x1ff8, 0x1c38,
+    0x381c, 0x381c, 0x381c, 0x381c, 0x1c38, 0x07e0, 0x0ff0, 0x1c38,
+    0x381c, 0x381c, 0x381c, 0x381c, 0x381c, 0x1c38, 0x1ff8, 0x07e0,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000 },
+  /* '9' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x07c0, 0x0ff0, 0x1c38,
+    0x3838, 0x3818, 0x381c, 0x381c, 0x381c, 0x383c, 0x1c3c, 0x1fdc,
+    0x079c, 0x001c, 0x003c, 0x0038, 0x0038, 0x10f0, 0x1fe0, 0x0fc0,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000 },
+  /* ':' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0380, 0x0380, 0x0380, 0x0380, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0380, 0x0380, 0x0380, 0x0380,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000 },
+  /* ';' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0380, 0x0380, 0x0380, 0x0380, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0380, 0x0380, 0x0380, 0x0380,
+    0x0300, 0x0700, 0x0600, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000 },
+  /* '<' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0004, 0x003c, 0x00fc, 0x03e0, 0x1f80, 0x7c00, 0x7000,
+    0x7c00, 0x1f80, 0x03e0, 0x00fc, 0x003c, 0x0004, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000 },
+  /* '=' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x7ffc, 0x7ffc, 0x0000, 0x0000,
+    0x0000, 0x7ffc, 0x7ffc, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000 },
+  /* '>' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x4000, 0x7800, 0x7e00, 0x0f80, 0x03f0, 0x007c, 0x001c,
+    0x007c, 0x03f0, 0x0f80, 0x7e00, 0x7800, 0x4000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000 },
+  /* '?' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x07c0, 0x0ff0, 0x1878,
+    0x1038, 0x0038, 0x0078, 0x00f0, 0x01e0, 0x01c0, 0x03c0, 0x0380,
+    0x0380, 0x0380, 0x0380, 0x0000, 0x0000, 0x0380, 0x0380, 0x0380,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000 },
+  /* '@' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x01f8, 0x07fc,
+    0x0e0e, 0x1c06, 0x3803, 0x3003, 0x307b, 0x61ff, 0x6187, 0x6303,
+    0x6303, 0x6303, 0x6303, 0x6187, 0x61ff, 0x307b, 0x3000, 0x1800,
+    0x1c00, 0x0f04, 0x07fc, 0x01fc, 0x0000, 0x0000, 0x0000, 0x0000 },
+  /* 'A' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x01c0, 0x03e0, 0x03e0,
+    0x03e0, 0x03e0, 0x0770, 0x0770, 0x0770, 0x0e38, 0x0e38, 0x0e38,
+    0x1c1c, 0x1ffc, 0x1ffc, 0x3c1e, 0x380e, 0x380e, 0x780f, 0x7007,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000 },
+  /* 'B' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x7f80, 0x7fe0, 0x70e0,
+    0x7070, 0x7070, 0x7070, 0x7070, 0x70e0, 0x7fc0, 0x7fc0, 0x7070,
+    0x7030, 0x7038, 0x7038, 0x7038, 0x7038, 0x7070, 0x7ff0, 0x7fc0,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000 },
+  /* 'C' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x03f0, 0x0ff8, 0x1e18,
+    0x3c08, 0x3800, 0x7000, 0x7000, 0x7000, 0x7000, 0x7000, 0x7000,
+    0x7000, 0x7000, 0x7000, 0x3800, 0x3808, 0x1e18, 0x0ff8, 0x03f0,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000 },
+  /* 'D' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x7f00, 0x7fc0, 0x70e0,
+    0x7070, 0x7070, 0x7038, 0x7038, 0x7038, 0x7038, 0x7038, 0x7038,
+    0x7038, 0x7038, 0x7038, 0x7070, 0x7070, 0x70e0, 0x7fc0, 0x7f00,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000 },
+  /* 'E' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x7ff8, 0x7ff8, 0x7000,
+    0x7000, 0x7000, 0x7000, 0x7000, 0x7000, 0x7ff0, 0x7ff0, 0x7000,
+    0x7000, 0x7000, 0x7000, 0x7000, 0x7000, 0x7000, 0x7ff8, 0x7ff8,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000 },
+  /* 'F' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x7ff8, 0x7ff8, 0x7000,
+    0x7000, 0x7000, 0x7000, 0x7000, 0x7000, 0x7ff0, 0x7ff0, 0x7000,
+    0x7000, 0x7000, 0x7000, 0x7000, 0x7000, 0x7000, 0x7000, 0x7000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000 },
+  /* 'G' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x03f0, 0x0ff8, 0x1e18,
+    0x3808, 0x3800, 0x7000, 0x7000, 0x7000, 0x7000, 0x70fc, 0x70fc,
+    0x701c, 0x701c, 0x701c, 0x381c, 0x381c, 0x1c1c, 0x0ffc, 0x03f0,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000 },
+  /* 'H' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x7038, 0x7038, 0x7038,
+    0x7038, 0x7038, 0x7038, 0x7038, 0x7038, 0x7ff8, 0x7ff8, 0x7038,
+    0x7038, 0x7038, 0x7038, 0x7038, 0x7038, 0x7038, 0x7038, 0x7038,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000 },
+  /* 'I' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x1ffc, 0x1ffc, 0x01c0,
+    0x01c0, 0x01c0, 0x01c0, 0x01c0, 0x01c0, 0x01c0, 0x01c0, 0x01c0,
+    0x01c0, 0x01c0, 0x01c0, 0x01c0, 0x01c0, 0x01c0, 0x1ffc, 0x1ffc,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000 },
+  /* 'J' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0ff0, 0x0ff0, 0x0070,
+    0x0070, 0x0070, 0x0070, 0x0070, 0x0070, 0x0070, 0x0070, 0x0070,
+    0x0070, 0x0070, 0x0070, 0x0070, 0x4070, 0x60e0, 0x7fe0, 0x1f80,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000 },
+  /* 'K' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x700e, 0x701c, 0x7038,
+    0x7070, 0x70e0, 0x71c0, 0x7380, 0x7700, 0x7f00, 0x7f80, 0x7bc0,
+    0x71c0, 0x71e0, 0x70f0, 0x7070, 0x7078, 0x703c, 0x701c, 0x701e,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000 },
+  /* 'L' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x7000, 0x7000, 0x7000,
+    0x7000, 0x7000, 0x7000, 0x7000, 0x7000, 0x7000, 0x7000, 0x7000,
+    0x7000, 0x7000, 0x7000, 0x7000, 0x7000, 0x7000, 0x7ff8, 0x7ff8,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000 },
+  /* 'M' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x783c, 0x783c, 0x7c7c,
+    0x7c7c, 0x7c7c, 0x745c, 0x76dc, 0x76dc, 0x729c, 0x739c, 0x739c,
+    0x739c, 0x701c, 0x701c, 0x701c, 0x701c, 0x701c, 0x701c, 0x701c,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000 },
+  /* 'N' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x7838, 0x7838, 0x7c38,
+    0x7c38, 0x7c38, 0x7638, 0x7638, 0x7638, 0x7338, 0x7338, 0x7338,
+    0x71b8, 0x71b8, 0x71b8, 0x70f8, 0x70f8, 0x70f8, 0x7078, 0x7078,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000 },
+  /* 'O' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x07c0, 0x1ff0, 0x1c70,
+    0x3838, 0x3838, 0x701c, 0x701c, 0x701c, 0x701c, 0x701c, 0x701c,
+    0x701c, 0x701c, 0x701c, 0x3838, 0x3838, 0x3c70, 0x1ff0, 0x07c0,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000 },
+  /* 'P' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x7fc0, 0x7fe0, 0x7070,
+    0x7038, 0x7038, 0x7038, 0x7038, 0x7038, 0x7070, 0x7ff0, 0x7fc0,
+    0x7000, 0x7000, 0x7000, 0x7000, 0x7000, 0x7000, 0x7000, 0x7000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000 },
+  /* 'Q' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x07c0, 0x1ff0, 0x1c70,
+    0x3838, 0x3838, 0x701c, 0x701c, 0x701c, 0x701c, 0x701c, 0x701c,
+    0x701c, 0x701c, 0x701c, 0x3838, 0x3838, 0x3c70, 0x1ff0, 0x07c0,
+    0x00e0, 0x0078, 0x0030, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000 },
+  /* 'R' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x7fc0, 0x7fe0, 0x7070,
+    0x7038, 0x7038, 0x7038, 0x7038, 0x7038, 0x7070, 0x7fe0, 0x7fc0,
+    0x71e0, 0x70f0, 0x7070, 0x7078, 0x7038, 0x703c, 0x701c, 0x701e,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000 },
+  /* 'S' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0fe0, 0x1ff0, 0x3c30,
+    0x7010, 0x7000, 0x7000, 0x7800, 0x7e00, 0x3fc0, 0x1ff0, 0x01f0,
+    0x0078, 0x0038, 0x0038, 0x0038, 0x4038, 0x70f0, 0x7fe0, 0x1fc0,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000 },
+  /* 'T' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x7fff, 0x7fff, 0x01c0,
+    0x01c0, 0x01c0, 0x01c0, 0x01c0, 0x01c0, 0x01c0, 0x01c0, 0x01c0,
+    0x01c0, 0x01c0, 0x01c0, 0x01c0, 0x01c0, 0x01c0, 0x01c0, 0x01c0,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000 },
+  /* 'U' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x7038, 0x7038, 0x7038,
+    0x7038, 0x7038, 0x7038, 0x7038, 0x7038, 0x7038, 0x7038, 0x7038,
+    0x7038, 0x7038, 0x7038, 0x7038, 0x7038, 0x3870, 0x1fe0, 0x0fc0,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000 },
+  /* 'V' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x700e, 0x781e, 0x381c,
+    0x381c, 0x381c, 0x1c38, 0x1c38, 0x1c38, 0x1e78, 0x0e70, 0x0e70,
+    0x0e70, 0x07e0, 0x07e0, 0x07e0, 0x07e0, 0x03c0, 0x03c0, 0x03c0,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000 },
+  /* 'W' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0xe007, 0xe007, 0xe007,
+    0x700e, 0x700e, 0x718e, 0x73ce, 0x73ce, 0x73ce, 0x73ce, 0x3e5c,
+    0x3e7c, 0x3e7c, 0x3e7c, 0x3c3c, 0x3c3c, 0x1c3c, 0x1c38, 0x1c18,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000 },
+  /* 'X' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x780f, 0x3c1e, 0x1c1c,
+    0x1e3c, 0x0f78, 0x0770, 0x07f0, 0x03e0, 0x01c0, 0x01c0, 0x03e0,
+    0x07e0, 0x0770, 0x0f78, 0x0e38, 0x1e3c, 0x3c1c, 0x380e, 0x780f,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000 },
+  /* 'Y' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x780f, 0x380e, 0x3c1e,
+    0x1c1c, 0x0e38, 0x0f78, 0x0770, 0x07f0, 0x03e0, 0x03e0, 0x01c0,
+    0x01c0, 0x01c0, 0x01c0, 0x01c0, 0x01c0, 0x01c0, 0x01c0, 0x01c0,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000 },
+  /* 'Z' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x7ffc, 0x7ffc, 0x003c,
+    0x0078, 0x0070, 0x00f0, 0x00e0, 0x01e0, 0x03c0, 0x0380, 0x0780,
+    0x0f00, 0x0e00, 0x1e00, 0x1c00, 0x3c00, 0x7800, 0x7ffc, 0x7ffc,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000 },
+  /* '[' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x03f0, 0x03f0, 0x0380, 0x0380,
+    0x0380, 0x0380, 0x0380, 0x0380, 0x0380, 0x0380, 0x0380, 0x0380,
+    0x0380, 0x0380, 0x0380, 0x0380, 0x0380, 0x0380, 0x0380, 0x0380,
+    0x0380, 0x03f0, 0x03f0, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000 },
+  /* '\\' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x7000, 0x3800, 0x3800,
+    0x1c00, 0x1c00, 0x0e00, 0x0e00, 0x0700, 0x0700, 0x0380, 0x0380,
+    0x0380, 0x01c0, 0x01c0, 0x00e0, 0x00e0, 0x0070, 0x0070, 0x0038,
+    0x0038, 0x001c, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000 },
+  /* ']' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0fc0, 0x0fc0, 0x01c0, 0x01c0,
+    0x01c0, 0x01c0, 0x01c0, 0x01c0, 0x01c0, 0x01c0, 0x01c0, 0x01c0,
+    0x01c0, 0x01c0, 0x01c0, 0x01c0, 0x01c0, 0x01c0, 0x01c0, 0x01c0,
+    0x01c0, 0x0fc0, 0x0fc0, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000 },
+  /* '^' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x03c0, 0x03c0, 0x07e0,
+    0x0e70, 0x1c38, 0x381c, 0x700e, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000 },
+  /* '_' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0xffff, 0xffff, 0x0000, 0x0000 },
+  /* '`' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0e00, 0x0700, 0x0300, 0x0180, 0x00c0,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000 },
+  /* 'a' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x07e0, 0x1ff8, 0x1038, 0x001c, 0x001c, 0x07fc,
+    0x1ffc, 0x3c1c, 0x381c, 0x381c, 0x383c, 0x3c7c, 0x1fdc, 0x0f9c,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000 },
+  /* 'b' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x3800, 0x3800, 0x3800, 0x3800,
+    0x3800, 0x3800, 0x39e0, 0x3ff0, 0x3c38, 0x3c38, 0x381c, 0x381c,
+    0x381c, 0x381c, 0x381c, 0x381c, 0x3c38, 0x3c38, 0x3ff0, 0x39e0,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000 },
+  /* 'c' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x03e0, 0x0ff0, 0x1e18, 0x1c00, 0x3800, 0x3800,
+    0x3800, 0x3800, 0x3800, 0x3800, 0x1c00, 0x1e18, 0x0ff0, 0x03e0,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000 },
+  /* 'd' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x001c, 0x001c, 0x001c, 0x001c,
+    0x001c, 0x001c, 0x079c, 0x0ffc, 0x1c7c, 0x3c3c, 0x381c, 0x381c,
+    0x381c, 0x381c, 0x381c, 0x381c, 0x1c3c, 0x1c7c, 0x0ffc, 0x079c,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000 },
+  /* 'e' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x03f0, 0x0ff8, 0x1e3c, 0x1c1c, 0x380e, 0x380e,
+    0x3ffe, 0x3ffe, 0x3800, 0x3800, 0x1c00, 0x1e0c, 0x0ffc, 0x03f0,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000 },
+  /* 'f' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x00fc, 0x01fc, 0x03c0, 0x0380,
+    0x0380, 0x0380, 0x3ffc, 0x3ffc, 0x0380, 0x0380, 0x0380, 0x0380,
+    0x0380, 0x0380, 0x0380, 0x0380, 0x0380, 0x0380, 0x0380, 0x0380,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000 },
+  /* 'g' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x079c, 0x0ffc, 0x1e3c, 0x1c3c, 0x381c, 0x381c,
+    0x381c, 0x381c, 0x381c, 0x381c, 0x1c3c, 0x1e3c, 0x0fdc, 0x079c,
+    0x001c, 0x001c, 0x0838, 0x0ff0, 0x07e0, 0x0000, 0x0000, 0x0000 },
+  /* 'h' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x3800, 0x3800, 0x3800, 0x3800,
+    0x3800, 0x3800, 0x39e0, 0x3bf0, 0x3c78, 0x3838, 0x3838, 0x3838,
+    0x3838, 0x3838, 0x3838, 0x3838, 0x3838, 0x3838, 0x3838, 0x3838,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000 },
+  /* 'i' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x01c0, 0x01c0, 0x01c0, 0x0000,
+    0x0000, 0x0000, 0x1fc0, 0x1fc0, 0x01c0, 0x01c0, 0x01c0, 0x01c0,
+    0x01c0, 0x01c0, 0x01c0, 0x01c0, 0x01c0, 0x01c0, 0x3ffe, 0x3ffe,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000 },
+  /* 'j' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x00e0, 0x00e0, 0x00e0, 0x0000,
+    0x0000, 0x0000, 0x0fe0, 0x0fe0, 0x00e0, 0x00e0, 0x00e0, 0x00e0,
+    0x00e0, 0x00e0, 0x00e0, 0x00e0, 0x00e0, 0x00e0, 0x00e0, 0x00e0,
+    0x00e0, 0x00e0, 0x01e0, 0x1fc0, 0x1f00, 0x0000, 0x0000, 0x0000 },
+  /* 'k' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x1c00, 0x1c00, 0x1c00, 0x1c00,
+    0x1c00, 0x1c00, 0x1c1e, 0x1c3c, 0x1c78, 0x1cf0, 0x1de0, 0x1fc0,
+    0x1fc0, 0x1fe0, 0x1fe0, 0x1ef0, 0x1c78, 0x1c38, 0x1c3c, 0x1c1e,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000 },
+  /* 'l' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x7f80, 0x7f80, 0x0380, 0x0380,
+    0x0380, 0x0380, 0x0380, 0x0380, 0x0380, 0x0380, 0x0380, 0x0380,
+    0x0380, 0x0380, 0x0380, 0x0380, 0x0380, 0x03c0, 0x01fc, 0x00fc,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000 },
+  /* 'm' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x7778, 0x7f78, 0x739c, 0x739c, 0x739c, 0x739c,
+    0x739c, 0x739c, 0x739c, 0x739c, 0x739c, 0x739c, 0x739c, 0x739c,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000 },
+  /* 'n' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x39e0, 0x3bf0, 0x3c78, 0x3838, 0x3838, 0x3838,
+    0x3838, 0x3838, 0x3838, 0x3838, 0x3838, 0x3838, 0x3838, 0x3838,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000 },
+  /* 'o' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x07e0, 0x0ff0, 0x1c38, 0x1c38, 0x381c, 0x381c,
+    0x381c, 0x381c, 0x381c, 0x381c, 0x1c38, 0x1c38, 0x0ff0, 0x07e0,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000 },
+  /* 'p' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x39e0, 0x3ff0, 0x3c38, 0x3c38, 0x381c, 0x381c,
+    0x381c, 0x381c, 0x381c, 0x381c, 0x3c38, 0x3c38, 0x3ff0, 0x39e0,
+    0x3800, 0x3800, 0x3800, 0x3800, 0x3800, 0x0000, 0x0000, 0x0000 },
+  /* 'q' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x079c, 0x0ffc, 0x1c3c, 0x1c3c, 0x381c, 0x381c,
+    0x381c, 0x381c, 0x381c, 0x381c, 0x1c3c, 0x1c3c, 0x0ffc, 0x079c,
+    0x001c, 0x001c, 0x001c, 0x001c, 0x001c, 0x0000, 0x0000, 0x0000 },
+  /* 'r' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x073c, 0x077e, 0x07c2, 0x0780, 0x0700, 0x0700,
+    0x0700, 0x0700, 0x0700, 0x0700, 0x0700, 0x0700, 0x0700, 0x0700,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000 },
+  /* 's' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x07e0, 0x0ff0, 0x1e10, 0x1c00, 0x1e00, 0x1fc0,
+    0x0ff0, 0x03f8, 0x0078, 0x0038, 0x0038, 0x1078, 0x1ff0, 0x0fe0,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000 },
+  /* 't' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0700, 0x0700,
+    0x0700, 0x0700, 0x7ff8, 0x7ff8, 0x0700, 0x0700, 0x0700, 0x0700,
+    0x0700, 0x0700, 0x0700, 0x0700, 0x0700, 0x0780, 0x03f8, 0x01f8,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000 },
+  /* 'u' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x3838, 0x3838, 0x3838, 0x3838, 0x3838, 0x3838,
+    0x3838, 0x3838, 0x3838, 0x3838, 0x3878, 0x3c78, 0x1fb8, 0x0f38,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000 },
+  /* 'v' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x701c, 0x3838, 0x3838, 0x3838, 0x1c70, 0x1c70,
+    0x1ef0, 0x0ee0, 0x0ee0, 0x0fe0, 0x07c0, 0x07c0, 0x07c0, 0x0380,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000 },
+  /* 'w' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0xe007, 0xe007, 0x700e, 0x700e, 0x718e, 0x718e,
+    0x3bdc, 0x3bdc, 0x3a5c, 0x3e7c, 0x1e78, 0x1c38, 0x1c38, 0x1c38,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000 },
+  /* 'x' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x3c3c, 0x1e78, 0x0e70, 0x0ff0, 0x07e0, 0x03c0,
+    0x0180, 0x03c0, 0x07e0, 0x07e0, 0x0ff0, 0x1e78, 0x3c3c, 0x781e,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000 },
+  /* 'y' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x701c, 0x3838, 0x3838, 0x3c78, 0x1c70, 0x1c70,
+    0x0ee0, 0x0ee0, 0x0fe0, 0x07c0, 0x07c0, 0x0380, 0x0380, 0x0380,
+    0x0700, 0x0700, 0x0f00, 0x3e00, 0x3c00, 0x0000, 0x0000, 0x0000 },
+  /* 'z' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x1ffc, 0x1ffc, 0x003c, 0x0078, 0x00f0, 0x00e0,
+    0x01e0, 0x03c0, 0x0780, 0x0700, 0x0f00, 0x1e00, 0x1ffc, 0x1ffc,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000 },
+  /* '{' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x007c, 0x00fc, 0x01e0, 0x01c0,
+    0x01c0, 0x01c0, 0x01c0, 0x01c0, 0x01c0, 0x01c0, 0x0380, 0x1f00,
+    0x1f00, 0x0380, 0x01c0, 0x01c0, 0x01c0, 0x01c0, 0x01c0, 0x01c0,
+    0x01c0, 0x01e0, 0x00fc, 0x007c, 0x0000, 0x0000, 0x0000, 0x0000 },
+  /* '|' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0180, 0x0180, 0x0180, 0x0180,
+    0x0180, 0x0180, 0x0180, 0x0180, 0x0180, 0x0180, 0x0180, 0x0180,
+    0x0180, 0x0180, 0x0180, 0x0180, 0x0180, 0x0180, 0x0180, 0x0180,
+    0x0180, 0x0180, 0x0180, 0x0180, 0x0180, 0x0180, 0x0000, 0x0000 },
+  /* '}' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x1f00, 0x1f80, 0x03c0, 0x01c0,
+    0x01c0, 0x01c0, 0x01c0, 0x01c0, 0x01c0, 0x01c0, 0x00e0, 0x007c,
+    0x007c, 0x00e0, 0x01c0, 0x01c0, 0x01c0, 0x01c0, 0x01c0, 0x01c0,
+    0x01c0, 0x03c0, 0x1f80, 0x1f00, 0x0000, 0x0000, 0x0000, 0x0000 },
+  /* '~' */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x1e00, 0x7f8c,
+    0x61fc, 0x00f0, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000 },
+  /* mu */
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x3838, 0x3838, 0x3838, 0x3838, 0x3838, 0x3838,
+    0x3838, 0x3838, 0x3838, 0x3838, 0x3838, 0x3c78, 0x3fde, 0x3b9e,
+    0x3800, 0x3800, 0x3800, 0x3800, 0x3800, 0x0000, 0x0000, 0x0000 },
+};
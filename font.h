@@ -0,0 +1,18 @@
+#ifndef FONT_H
+#define FONT_H
+#include "binarytype.h"
+
+/* 16x32 bitmap font of printable ASCII and µ, rasterized
+** from DejaVu Sans Mono (Bitstream Vera license).
+** Bit 15 of a row is the leftmost pixel.
+*/
+
+#define FONT_WIDTH    16
+#define FONT_HEIGHT   32
+#define FONT_FIRST    32 /* glyph 0 is space */
+#define FONT_MU       95 /* glyph of µ */
+#define FONT_GLYPHS   96
+
+extern const u16 font_glyph[FONT_GLYPHS][FONT_HEIGHT];
+
+#endif
@@ -0,0 +1,574 @@
+/* libdcm300.c
+**
+** Reentrant capture session: request, bulk reads
+** through the caller's transport, processing hooks
+** and on-the-fly RGB conversion delivered row by row
+**
+** License: GPL
+**
+*/
+#include "libdcm300.h"
+#include "session.h"
+#include "pipeline.h"
+#include "bayer.h"
+#include "demosaic.h"
+#include "ring.h"
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <dirent.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifndef DCM300_SYSFS
+#define DCM300_SYSFS "/sys/bus/usb/devices"
+#endif
+
+/* monotonic time in nanoseconds */
+u64 dcm300_ns(void)
+{
+  struct timespec t;
+
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec * 1000000000ULL + t.tv_nsec;
+}
+
+void dcm300_request_init(struct dcm300_request *r, const struct dcm300_snapshot *s)
+{
+  memset(r, 0, sizeof(*r));
+
+  r->unknown1a = 0x2c;
+  r->unknown1b = 0x0e;
+  r->unknown1c = 0x01;
+
+  r->unknown2 = 0x20;
+  r->unknown3 = 0x05;
+  r->unknown9 = 0x02;
+
+  r->resolution_x_lo = (s->w) % 256;
+  r->resolution_x_hi = (s->w) / 256;
+  r->resolution_y_lo = (s->h) % 256;
+  r->resolution_y_hi = (s->h) / 256;
+
+  r->offset_x_lo = (s->x) % 256;
+  r->offset_x_hi = (s->x) / 256;
+
+  r->offset_y_lo = (s->y) % 256;
+  r->offset_y_hi = (s->y) / 256;
+
+  r->exposure_lo = (s->exposure + 20) % 256;
+  r->exposure_hi = (s->exposure + 20) / 256;
+
+  r->gain_red   = s->red;
+  r->gain_green = s->green;
+  r->gain_blue  = s->blue;
+
+  r->gamma = 191;
+}
+
+/* numeric attribute of a sysfs usb device, -1 if missing */
+static int dcm300_sysfs_attr(const char *id, const char *attr, int base)
+{
+  char path[PATH_MAX], value[32];
+  FILE *f;
+  int n = -1;
+
+  snprintf(path, sizeof(path), DCM300_SYSFS "/%s/%s", id, attr);
+  f = fopen(path, "r");
+  if(f == NULL)
+    return -1;
+  if(fgets(value, sizeof(value), f))
+    n = strtol(value, NULL, base);
+  fclose(f);
+  return n;
+}
+
+static int dcm300_camera_compare(const void *a, const void *b)
+{
+  return strcmp(((const struct dcm300_camera *) a)->id, ((const struct dcm300_camera *) b)->id);
+}
+
+/* attached cameras sorted by id, without opening them.
+** returns number of cameras or -1 without sysfs
+*/
+int dcm300_enumerate(struct dcm300_camera *list, int max)
+{
+  DIR *dir;
+  struct dirent *e;
+  int n = 0;
+
+  dir = opendir(DCM300_SYSFS);
+  if(dir == NULL)
+    return -1;
+  while(n < max && (e = readdir(dir)) != NULL)
+  {
+    /* interfaces are named BUS-PORT:CONFIG.INTERFACE */
+    if(e->d_name[0] == '.' || strchr(e->d_name, ':') || strlen(e->d_name) >= sizeof(list->id))
+      continue;
+    if(dcm300_sysfs_attr(e->d_name, "idVendor", 16) != DCM300_VENDOR
+    || dcm300_sysfs_attr(e->d_name, "idProduct", 16) != DCM300_PRODUCT)
+      continue;
+    strcpy(list[n].id, e->d_name);
+    list[n].bus = dcm300_sysfs_attr(e->d_name, "busnum", 10);
+    list[n].dev = dcm300_sysfs_attr(e->d_name, "devnum", 10);
+    list[n].speed = dcm300_sysfs_attr(e->d_name, "speed", 10);
+    n++;
+  }
+  closedir(dir);
+  qsort(list, n, sizeof(*list), dcm300_camera_compare);
+  return n;
+}
+
+/* attached camera by port id (3-1.2) or Bus:Device (003:012),
+** returns 0 if found
+*/
+int dcm300_camera_find(struct dcm300_camera *camera, const char *spec)
+{
+  struct dcm300_camera list[DCM300_CAMERAS];
+  int i, n, bus = -1, dev = -1;
+  char end;
+
+  if(sscanf(spec, "%d:%d%c", &bus, &dev, &end) != 2)
+    bus = dev = -1;
+  n = dcm300_enumerate(list, DCM300_CAMERAS);
+  for(i = 0; i < n; i++)
+    if(strcmp(list[i].id, spec) == 0 || (list[i].bus == bus && list[i].dev == dev))
+    {
+      *camera = list[i];
+      return 0;
+    }
+  return -1;
+}
+
+/* usbfs device node of a camera by Bus:Device (003:012)
+** or port id (3-1.2) without enumerating the bus.
+** Returns 0 if path was made
+*/
+int dcm300_camera_node(const char *spec, char *path, int size)
+{
+  int bus, dev;
+  char end;
+
+  if(sscanf(spec, "%d:%d%c", &bus, &dev, &end) != 2)
+  {
+    /* port id names one directory of sysfs */
+    if(strchr(spec, '/')
+    || dcm300_sysfs_attr(spec, "idVendor", 16) != DCM300_VENDOR
+    || dcm300_sysfs_attr(spec, "idProduct", 16) != DCM300_PRODUCT)
+      return -1;
+    bus = dcm300_sysfs_attr(spec, "busnum", 10);
+    dev = dcm300_sysfs_attr(spec, "devnum", 10);
+  }
+  if(bus <= 0 || dev <= 0)
+    return -1;
+  snprintf(path, size, "/dev/bus/usb/%03d/%03d", bus, dev);
+  return 0;
+}
+
+/* ring holds a bulk and the unconverted rest of a block
+** of binned rows, pipelined also the queued bulks
+*/
+struct dcm300_session *dcm300_session_create(const struct dcm300_transport *t,
+                                             const struct dcm300_config *config,
+                                             const struct dcm300_hooks *hooks)
+{
+  struct dcm300_session *session;
+  struct dcm300_config *c;
+  int min;
+
+  session = calloc(1, sizeof(*session));
+  if(session == NULL)
+    return NULL;
+  session->t = *t;
+  if(config)
+    session->config = *config;
+  if(hooks)
+    session->hooks = *hooks;
+  c = &session->config;
+  if(c->bulk <= 0)
+    c->bulk = DCM300_BULK;
+  if(c->ring <= 0)
+    c->ring = DCM300_BAYER_RING;
+  if(c->depth < 0)
+    c->depth = 0;
+  min = (c->depth + 1) * c->bulk + DCM300_BIN_MAX * DCM300_WIDTH;
+  if(c->ring < min)
+    c->ring = min;
+  if(ring_create(&session->bayer, c->ring) < 0)
+  {
+    dcm300_session_destroy(session);
+    return NULL;
+  }
+  c->ring = session->bayer.size;
+  /* rows of a whole transfer, RGB of 2x2 binning is 3/4 of its bytes */
+  session->rgb = malloc(3 * c->ring / 4);
+  if(session->rgb == NULL
+  || (c->depth > 0 && (session->pipeline = pipeline_create(session)) == NULL))
+  {
+    dcm300_session_destroy(session);
+    return NULL;
+  }
+  return session;
+}
+
+void dcm300_session_destroy(struct dcm300_session *session)
+{
+  if(session == NULL)
+    return;
+  if(session->pinned)
+  {
+    munlock(session->rgb, 3 * session->config.ring / 4);
+    pipeline_unpin(session->pipeline);
+  }
+  pipeline_destroy(session->pipeline);
+  ring_destroy(&session->bayer);
+  free(session->rgb);
+  free(session);
+}
+
+/* lock the buffers transfers are read into and rows are
+** converted in, no page fault in the middle of a bulk.
+** Both halves of the ring, the mirror has page tables of
+** its own
+*/
+int dcm300_session_pin(struct dcm300_session *session)
+{
+  if(mlock(session->bayer.base, 2 * session->bayer.size)
+  || mlock(session->rgb, 3 * session->config.ring / 4)
+  || pipeline_pin(session->pipeline))
+    return -1;
+  session->pinned = 1;
+  return 0;
+}
+
+/* NULL if the session is not pipelined */
+const struct dcm300_pipeline_stats *dcm300_session_pipeline(struct dcm300_session *session)
+{
+  return session->pipeline ? &session->pipeline->counters : NULL;
+}
+
+static void dcm300_session_event(struct dcm300_session *session, int event,
+                                 const struct dcm300_snapshot *s)
+{
+  if(session->hooks.event)
+    session->hooks.event(session->hooks.param, event, s);
+}
+
+/* warm-up frame of snapshot s: DCM300_WARMUP square in the
+** middle of its window, kept inside the sensor
+*/
+void dcm300_warmup_window(struct dcm300_snapshot *small, const struct dcm300_snapshot *s)
+{
+  *small = *s;
+  small->w = small->h = DCM300_WARMUP;
+  small->x = (s->x + (s->w - DCM300_WARMUP) / 2) & ~1;
+  small->y = (s->y + (s->h - DCM300_WARMUP) / 2) & ~1;
+  /* windows smaller than the warm-up frame */
+  if(small->x < 0)
+    small->x = 0;
+  if(small->x > DCM300_WIDTH - DCM300_WARMUP)
+    small->x = DCM300_WIDTH - DCM300_WARMUP;
+  if(small->y < 0)
+    small->y = 0;
+  if(small->y > DCM300_HEIGHT - DCM300_WARMUP)
+    small->y = DCM300_HEIGHT - DCM300_WARMUP;
+}
+
+/* rows to the callback, or to the writer thread when
+** pipelined. Time spent here is not conversion time
+*/
+static int dcm300_session_deliver(struct dcm300_session *session, u8 *data, int len)
+{
+  u64 t = session->hooks.convert ? dcm300_ns() : 0;
+  int result;
+
+  if(session->pipelined)
+    result = pipeline_output(session, data, len);
+  else
+    result = session->cbfunc(session->param, len, data);
+  if(result < 0)
+    session->error = 1;
+  if(session->hooks.convert)
+    session->deliver_ns += dcm300_ns() - t;
+  return result;
+}
+
+/* full resolution demosaic delivers rows here */
+static int dcm300_session_demosaic(void *param, unsigned bytes, void *data)
+{
+  return dcm300_session_deliver((struct dcm300_session *) param, data, bytes);
+}
+
+/* convert each complete group of bin bayer rows up to
+** bayer_stop, rows of one transfer go out together.
+** The ring is mirrored, rows of a group are contiguous
+** even where they wrap. Full resolution rows are pushed
+** to the demosaic
+*/
+static void dcm300_session_rows(struct dcm300_session *session, int bayer_stop)
+{
+  const struct dcm300_snapshot *s = session->s;
+  int bin = s->bin, width = s->w, from = session->bayer_from, irgb = 0;
+  u64 t = 0, deliver_ns = session->deliver_ns;
+  const u8 *rows;
+
+  if(bayer_stop > session->bayer_end)
+    bayer_stop = session->bayer_end;
+  if(session->hooks.convert)
+    t = dcm300_ns();
+  for(; session->bayer_from + bin*width <= bayer_stop; session->bayer_from += bin*width)
+  {
+    rows = ring_at(&session->bayer, session->bayer_from);
+    if(bin == 1)
+      demosaic_push(session->d, rows);
+    else if(bin == 2)
+      bayer_downscale_row(rows, rows + width, session->rgb + irgb, width);
+    else
+      bayer_bin_rows(rows, width, bin, session->rgb + irgb);
+    if(bin > 1)
+      irgb += 3*width/bin;
+  }
+  /* rows the demosaic delivered meanwhile are not conversion */
+  if(session->hooks.convert && session->bayer_from > from)
+    session->hooks.convert(session->hooks.param,
+      dcm300_ns() - t - (session->deliver_ns - deliver_ns), session->bayer_from - from);
+  if(irgb > 0)
+    dcm300_session_deliver(session, session->rgb, irgb);
+}
+
+/* corrected bytes at bayer_read: metered, then added to
+** the stack, passed on raw or converted
+*/
+static void dcm300_session_convert(struct dcm300_session *session, int len)
+{
+  struct dcm300_hooks *h = &session->hooks;
+  u8 *data = ring_at(&session->bayer, session->bayer_read);
+
+  if(h->meter)
+    h->meter(h->param, session->bayer_read, data, len);
+  if(session->warming)
+    ;
+  else if(session->stacking)
+  {
+    if(h->stack_add)
+      h->stack_add(h->param, session->bayer_read, data, len);
+  }
+  else if(session->s->raw)
+    dcm300_session_deliver(session, data, len);
+  else
+    dcm300_session_rows(session, session->bayer_read + len);
+  session->bayer_read += len;
+}
+
+/* len bytes just read to bayer_read, corrected in the
+** ring before anything else sees them
+*/
+void dcm300_session_process(struct dcm300_session *session, int len)
+{
+  if(len <= 0)
+    return;
+  if(session->hooks.correct && !session->warming)
+    session->hooks.correct(session->hooks.param, &session->bayer, session->bayer_read, len);
+  dcm300_session_convert(session, len);
+}
+
+/* ring position conversion still needs: raw output and
+** stacking are done with everything read, others keep
+** the incomplete rows
+*/
+int dcm300_session_needed(struct dcm300_session *session)
+{
+  return session->s->raw || session->stacking ? session->bayer_read : session->bayer_from;
+}
+
+/* read next transfer into the ring and process it,
+** or queue it for the conversion thread when pipelined
+*/
+static int dcm300_session_receive(struct dcm300_session *session, int want)
+{
+  int len;
+
+  if(session->pipelined)
+    return pipeline_read(session, want);
+  len = session->t.read(session->t.ctx, ring_at(&session->bayer, session->bayer_read), want);
+  dcm300_session_process(session, len);
+  return len;
+}
+
+/* the row callback asked to stop, known only after
+** a pipelined frame
+*/
+static int dcm300_session_stopped(struct dcm300_session *session)
+{
+  return !session->pipelined && session->error;
+}
+
+/*
+** request frame s and read its header, image and footer.
+** Each bulk is read at its stream position in the ring,
+** which holds a bulk and the rows still waiting for the
+** rest of their group, so a bulk never overwrites them.
+** Returns -1 if a read failed or the image came short
+*/
+static int dcm300_session_frame(struct dcm300_session *session, const struct dcm300_snapshot *s,
+                                int event)
+{
+  struct dcm300_request r[1];
+  int image_len = s->w * s->h, bulk = session->config.bulk;
+  int i, len, want, result = 0;
+
+  dcm300_session_event(session, event, s);
+  session->bayer_read = -DCM300_HEADER;
+  session->bayer_from = 0;
+  session->bayer_end = image_len;
+  dcm300_request_init(r, s);
+  if(session->t.expect && session->t.expect(session->t.ctx, image_len) < 0)
+    return -1;
+  if(session->t.write(session->t.ctx, (u8 *) r, sizeof(r)) != sizeof(r))
+    return -1;
+  /* from here on conversion and output run on their own threads */
+  if(session->pipeline && !session->warming)
+    pipeline_start(session);
+
+  len = dcm300_session_receive(session, DCM300_HEADER);
+  if(len == DCM300_HEADER)
+    dcm300_session_event(session, DCM300_EVENT_HEADER, s);
+  else
+    result = -1;
+  len = want = 0;
+  for(i = 0; i < image_len && len == want && !dcm300_session_stopped(session); i += len)
+  {
+    want = image_len - i > bulk ? bulk : image_len - i;
+    len = dcm300_session_receive(session, want);
+    if(len < 0)
+      break;
+    if(len == want)
+      dcm300_session_event(session, DCM300_EVENT_BULK, s);
+  }
+  if(len < 0 || dcm300_session_stopped(session))
+    result = -1;
+  else
+  {
+    /* rest of the image merged with the footer, or the footer alone */
+    want = image_len - i + DCM300_FOOTER;
+    if(want > bulk)
+      want = bulk;
+    len = dcm300_session_receive(session, want);
+    if(len == want)
+      dcm300_session_event(session, DCM300_EVENT_FOOTER, s);
+    if(len < 0 || i + len < image_len)
+      result = -1;
+  }
+  if(session->pipelined)
+  {
+    pipeline_finish(session);
+    session->pipelined = 0;
+  }
+  return session->error ? -1 : result;
+}
+
+/* a camera that has not completed a frame since it was
+** opened or since a capture was stopped blocks at the next
+** request, and it is stable only for DCM300_WARM_MS after
+** one. A tiny frame in the middle of the window of s
+** first does, one bulk instead of a frame. Its bytes
+** go to the meter hook only
+*/
+int dcm300_session_warmup(struct dcm300_session *session, const struct dcm300_snapshot *s)
+{
+  struct dcm300_snapshot small[1];
+  int result;
+
+  dcm300_warmup_window(small, s);
+  small->raw = 0;
+  small->frames = 0;
+  session->s = small;
+  session->warming = 1;
+  session->error = 0;
+  result = dcm300_session_frame(session, small, DCM300_EVENT_WARMUP);
+  session->warming = 0;
+  session->s = NULL;
+  session->warm = result == 0;
+  if(session->warm)
+    session->warm_ns = dcm300_ns();
+  return result;
+}
+
+/* frames of the stack go back to back, each bulk is added
+** as it arrives, so adding overlaps transfers still queued
+** or being read by the reader. The result then goes through
+** conversion bulk by bulk through the ring.
+** Returns -1 without result if a frame failed
+*/
+static int dcm300_session_stack(struct dcm300_session *session)
+{
+  const struct dcm300_snapshot *s = session->s;
+  struct dcm300_hooks *h = &session->hooks;
+  int n, pos, len, size = s->w * s->h, result = 0;
+
+  session->stacking = 1;
+  for(n = 0; n < s->frames && result == 0; n++)
+    result = dcm300_session_frame(session, s, DCM300_EVENT_FRAME);
+  session->stacking = 0;
+  /* a frame came short and is partly added, no result */
+  if(result)
+    return result;
+  dcm300_session_event(session, DCM300_EVENT_FRAME, s);
+  session->bayer_read = session->bayer_from = 0;
+  session->bayer_end = size;
+  for(pos = 0; pos < size && !session->error; pos += len)
+  {
+    len = size - pos > session->config.bulk ? session->config.bulk : size - pos;
+    if(h->stack_result)
+      h->stack_result(h->param, n, pos, ring_at(&session->bayer, pos), len);
+    dcm300_session_convert(session, len);
+  }
+  return session->error ? -1 : 0;
+}
+
+/*
+** capture the window of s as RGB w/bin x h/bin, or its
+** raw stream. Returns 0 when the whole image was delivered
+*/
+int dcm300_session_capture(struct dcm300_session *session, const struct dcm300_snapshot *s,
+                           dcm300_rows_callback cbfunc, void *param)
+{
+  int result;
+
+  if(s->w < DCM300_ALIGN_X || s->w > DCM300_WIDTH || s->h < DCM300_ALIGN_Y || s->h > DCM300_HEIGHT
+  || (s->bin != 1 && s->bin != 2 && s->bin != 4 && s->bin != 8) || s->frames < 0)
+    return -1;
+  if((!session->warm || dcm300_ns() - session->warm_ns > DCM300_WARM_MS * 1000000ULL)
+  && dcm300_session_warmup(session, s) < 0)
+    return -1;
+  session->warm = 0;
+  session->s = s;
+  session->cbfunc = cbfunc;
+  session->param = param;
+  session->error = 0;
+  session->d = NULL;
+  if(s->bin == 1 && !s->raw)
+  {
+    session->d = demosaic_create(s->method, s->w, s->h, s->threads,
+                                 dcm300_session_demosaic, session);
+    if(session->d == NULL)
+      return -1;
+  }
+
+  if(s->frames > 0)
+    result = dcm300_session_stack(session);
+  else
+    result = dcm300_session_frame(session, s, DCM300_EVENT_FRAME);
+  if(result == 0)
+  {
+    session->warm = 1;
+    session->warm_ns = dcm300_ns();
+  }
+
+  demosaic_destroy(session->d);
+  session->d = NULL;
+  session->s = NULL;
+  return result;
+}
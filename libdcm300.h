@@ -0,0 +1,189 @@
+#ifndef LIBDCM300_H
+#define LIBDCM300_H
+#include "binarytype.h"
+
+/* capture library of the SANE backend and the command
+** line tool. A session is one open camera, any number of
+** sessions can capture at once in one process. The caller
+** owns the transport and the processing hooks, the session
+** owns its buffers and threads and lends the buffers to
+** the hooks and the row callback.
+*/
+
+/* sensor size, requested windows are multiples of
+** DCM300_ALIGN_X by DCM300_ALIGN_Y (800x600 is a known
+** device mode) and start at even offsets (bayer phase)
+*/
+#define DCM300_WIDTH   2048
+#define DCM300_HEIGHT  1536
+#define DCM300_ALIGN_X 16
+#define DCM300_ALIGN_Y 8
+
+/* USB ids of the camera */
+#define DCM300_VENDOR  0x1578
+#define DCM300_PRODUCT 0x0076
+
+/* most cameras dcm300_enumerate() returns */
+#define DCM300_CAMERAS 32
+
+/* camera stays stable only for a moment after a completed
+** frame, a capture later than this is warmed up again
+*/
+#define DCM300_WARM_MS 2000
+
+#define DCM300_WARMUP 128 /* pixels of the warm-up frame side */
+
+/* largest software binning, rows of one block must fit the ring */
+#define DCM300_BIN_MAX 8
+
+#define DCM300_BULK 16384 /* default bytes per bulk transfer of the image */
+#define DCM300_BAYER_RING 32768 /* default bytes of the bayer ring */
+
+/* request for dcm300 snapshot packet
+*/
+struct dcm300_request {
+  unsigned char unknown1a;      /* 2c */
+  unsigned char unknown1a_0[1]; /* 00 */
+  unsigned char unknown1b;      /* 0e */
+  unsigned char unknown1b_0[1]; /* 00 */
+  unsigned char unknown1c;      /* 01 */
+  unsigned char unknown1_0[7];  /* 00 ... */
+  unsigned char unknown2;       /* 20 */
+  unsigned char unknown2_0[1];  /* 00 ... */
+  unsigned char gamma;          /* maybe gamma maybe not, values seen: bf,d6,da,b0,e1 */
+  unsigned char unknown3;       /* 05 */
+  unsigned char resolution_y_lo, resolution_y_hi;
+  unsigned char unknown3_0[2];  /* 00 ... */
+  unsigned char resolution_x_lo, resolution_x_hi;
+  unsigned char unknown4_0[2];  /* 00 ... */
+  unsigned char offset_x_lo, offset_x_hi;
+  unsigned char offset_x_hlo, offset_x_hhi;
+  // unsigned char unknown5_0[2];  /* 00 ... */
+  unsigned char offset_y_lo, offset_y_hi;
+  unsigned char unknown6_0[2];  /* 00 ... */
+  unsigned char exposure_lo, exposure_hi; /* lo,hi = exp + 20 */
+  unsigned char unknown7_0[2];  /* 00 ... */
+  char gain_red, gain_green, gain_blue;
+  unsigned char unknown8_0[1];
+  unsigned char unknown9;       /* 02 */
+  unsigned char unknown9_0[23]; /* 00 ... */
+};
+
+/* parameters for taking a snapshot */
+struct dcm300_snapshot {
+  int x, y; /* sensor window offset, even */
+  int w, h; /* sensor window size, DCM300_ALIGN_X by DCM300_ALIGN_Y steps */
+  int exposure;
+  int red, green, blue; /* gains */
+  int bin; /* 1-full resolution demosaic, 2, 4 or 8-binning */
+  int method; /* DEMOSAIC_BILINEAR or DEMOSAIC_MHC for bin 1 */
+  int threads; /* demosaic worker threads for bin 1 */
+  int raw; /* 1-callback gets the bayer stream byte exact: header, image, footer */
+  int frames; /* 0-one frame, N-N frames through the stack hooks */
+};
+
+/* bulk transfers of the caller's USB stack, return
+** bytes transferred or -1. expect may be NULL, it gets the
+** image bytes of every frame before its request is written,
+** e.g. to queue the transfers of the whole frame
+*/
+struct dcm300_transport {
+  int (*write)(void *ctx, u8 *data, int len);
+  int (*read)(void *ctx, u8 *data, int len);
+  void *ctx;
+  int (*expect)(void *ctx, int image_bytes);
+};
+
+/* buffers and threads of a session, 0 is the default */
+struct dcm300_config {
+  int bulk; /* bytes per image transfer, DCM300_BULK */
+  int ring; /* bytes of the bayer ring, DCM300_BAYER_RING, grown to
+            ** hold the queued bulks and a block of binned rows */
+  int depth; /* 0-serial >0-bulks queued for the conversion thread */
+  int lossless; /* 1-reads wait for the conversion thread instead of
+                ** dropping bulks, only for a source that can wait (file) */
+};
+
+/* capture progress reported to the event hook */
+#define DCM300_EVENT_WARMUP 0 /* warm-up or metering frame s is requested */
+#define DCM300_EVENT_FRAME  1 /* frame s is requested, or the stack result follows */
+#define DCM300_EVENT_HEADER 2 /* header read */
+#define DCM300_EVENT_BULK   3 /* whole bulk of the image read */
+#define DCM300_EVENT_FOOTER 4 /* footer read */
+
+struct ring;
+
+/* processing of a capture, any hook may be NULL.
+** Bulks are passed at their stream position: the header
+** at -64, the image from 0 and the footer after it, each
+** hook keeps to the bytes it wants.
+** correct may change bytes in the ring before anything else
+** sees them, bytes read before stay at their positions.
+** meter also sees warm-up frames, uncorrected.
+** Frames of a stack go to stack_add instead of conversion,
+** stack_result then writes the image of the frames added
+** into the ring bulk by bulk.
+** convert gets the time of each conversion step, time in
+** the row callback excluded.
+** Pipelined all but event run on the conversion thread
+*/
+struct dcm300_hooks {
+  void (*event)(void *param, int event, const struct dcm300_snapshot *s);
+  void (*correct)(void *param, struct ring *ring, int pos, int len);
+  void (*meter)(void *param, int pos, const u8 *data, int len);
+  void (*stack_add)(void *param, int pos, const u8 *data, int len);
+  void (*stack_result)(void *param, int frames, int pos, u8 *out, int len);
+  void (*convert)(void *param, u64 ns, int bytes);
+  void *param;
+};
+
+/* counters of a pipelined session, summed over its captures */
+struct dcm300_pipeline_stats {
+  u64 chunks; /* bulks handed from reader to conversion */
+  u64 dropped_chunks; /* bulks the reader had no room for */
+  u64 dropped_bytes;
+  int queue_depth; /* capacity of reader to conversion queue */
+  int queue_max; /* its highest fill */
+  int out_size; /* bytes of conversion to writer ring */
+  int out_max; /* its highest fill */
+  u64 waits; /* times conversion waited for the writer */
+  u64 wait_ns; /* total time of these waits */
+};
+
+/* receives completed RGB rows, data is valid during the
+** call only. Return 0 to continue, -1 to stop the capture.
+** Pipelined it runs on a writer thread of its own, the
+** frame is then still read to its end
+*/
+typedef int (*dcm300_rows_callback) (void *param, unsigned bytes, void *data);
+
+/* attached camera. id is the sysfs port path e.g. 3-1.2,
+** it stays the same when the camera is replugged into the
+** same port, unlike the device number
+*/
+struct dcm300_camera {
+  char id[32];
+  int bus, dev; /* device node /dev/bus/usb/BBB/DDD */
+  int speed; /* Mbit/s */
+};
+
+struct dcm300_session; /* opaque */
+
+int dcm300_enumerate(struct dcm300_camera *list, int max);
+int dcm300_camera_find(struct dcm300_camera *camera, const char *spec);
+int dcm300_camera_node(const char *spec, char *path, int size);
+
+u64 dcm300_ns(void);
+void dcm300_request_init(struct dcm300_request *r, const struct dcm300_snapshot *s);
+void dcm300_warmup_window(struct dcm300_snapshot *small, const struct dcm300_snapshot *s);
+struct dcm300_session *dcm300_session_create(const struct dcm300_transport *t,
+                                             const struct dcm300_config *config,
+                                             const struct dcm300_hooks *hooks);
+int dcm300_session_warmup(struct dcm300_session *session, const struct dcm300_snapshot *s);
+int dcm300_session_capture(struct dcm300_session *session, const struct dcm300_snapshot *s,
+                           dcm300_rows_callback cbfunc, void *param);
+const struct dcm300_pipeline_stats *dcm300_session_pipeline(struct dcm300_session *session);
+int dcm300_session_pin(struct dcm300_session *session);
+void dcm300_session_destroy(struct dcm300_session *session);
+
+#endif
@@ -17,8 +17,14 @@
 // #include <sys/socket.h>
 
 #include "dcm300.h"
+#include "daemon.h"
+#include "multi.h"
 #include "cmdline.h"
 
+/* live view: centered window, 4x4 binned to 256x192 */
+#define PREVIEW_GEOMETRY "1024x768"
+#define PREVIEW_BIN 4
+
 struct gengetopt_args_info args_info;
 struct gengetopt_args_info *args = &args_info;
 
@@ -27,6 +33,9 @@ char *device = "/dev/ttyS0";
 
 int main(int argc, char **argv) 
 {
+  struct dcm300 device[1];
+  struct dcm300 *dcm300 = device;
+  int result = 0;
 #if 0
   struct bt_uart btuart;
   struct bt_role btrole;
@@ -48,31 +57,166 @@ int main(int argc, char **argv)
   char mac_str[100];
 #endif
 
+  memset(device, 0, sizeof(device));
+  dcm300->t_startup = dcm300_ns();
   cmdline_parser(argc, argv, args);
   verbose = args->verbose_given ? 1 : 0;
   dcm300->name = NULL;
   dcm300->simulation = 0;
 
+  if(args->dump_trace_given)
+    return trace_dump(args->dump_trace_arg) ? 1 : 0;
+  if(args->list_given)
+    return multi_list() ? 1 : 0;
+
   if(args->device_given)
   {
     dcm300->name = args->device_arg;
     if(strlen(dcm300->name) > 0)
       if(dcm300->name[0] == '/' || dcm300->name[0] == '.')
-        dcm300->simulation = 1;
+        dcm300->simulation = trace_probe(dcm300->name) ? 2 : 1;
+  }
+  dcm300->record_name = args->record_given ? args->record_arg : NULL;
+  if(args->all_given && (dcm300->simulation || args->record_given || args->preview_given
+  || args->daemon_given || args->stack_given || args->calibration_given))
+  {
+    fprintf(stderr, "--all takes plain snapshots of attached cameras\n");
+    return 1;
   }
 
   dcm300->exposure = args->exposure_arg;
+  dcm300->autoexposure = args->autoexposure_given ? 1 : 0;
+  dcm300->whitebalance = args->whitebalance_given ? 1 : 0;
+  dcm300->wb_mode = meter_wb_mode(args->wb_mode_arg);
+  dcm300->metered = 0;
+  dcm300->meter = NULL;
+  /* daemon meters for clients asking for auto exposure or white balance */
+  if((dcm300->autoexposure || dcm300->whitebalance || args->daemon_given)
+  && (dcm300->meter = meter_create()) == NULL)
+    return 1;
   dcm300->red	   = args->red_arg;
   dcm300->green	   = args->green_arg;
   dcm300->blue	   = args->blue_arg;
   dcm300->output   = STDOUT_FILENO;
+  dcm300->encoder  = NULL;
   
   dcm300->x        = 0;
   dcm300->y        = 0;
-  dcm300->w        = 2048;
-  dcm300->h        = 1536;
+  dcm300->w        = DCM300_WIDTH;
+  dcm300->h        = DCM300_HEIGHT;
+  /* preview defaults to a centered window, fewer bytes per frame */
+  if(args->preview_given && !args->geometry_given)
+    dcm300_geometry(dcm300, PREVIEW_GEOMETRY);
+  if(args->geometry_given && dcm300_geometry(dcm300, args->geometry_arg))
+    return 1;
 
   dcm300->raw = args->raw_given ? 1 : 0;
+  dcm300->demosaic = demosaic_method(args->demosaic_arg);
+  dcm300->bin = args->bin_given ? args->bin_arg : args->preview_given ? PREVIEW_BIN : 2;
+  if(dcm300->bin != 2 && dcm300->bin != 4 && dcm300->bin != 8)
+  {
+    fprintf(stderr, "bin must be 2, 4 or 8\n");
+    return 1;
+  }
+  dcm300->threads  = args->threads_arg;
+
+  dcm300->usbfs    = -1;
+  dcm300->urbs     = args->urbs_arg;
+  dcm300->bulk     = args->bulk_arg;
+  dcm300->ring_size = args->ring_arg;
+  dcm300->stack = NULL;
+  if(args->stack_given
+  && (dcm300->stack = stack_create(stack_mode(args->stack_mode_arg), args->stack_arg)) == NULL)
+    return 1;
+  if((args->calibrate_given || args->defects_given) && !args->calibration_given)
+  {
+    fprintf(stderr, "--calibrate and --defects need --calibration directory\n");
+    return 1;
+  }
+  if(args->defects_given)
+    return defect_detect(dcm300, args->calibration_arg) ? 1 : 0;
+  dcm300->calib = NULL;
+  if(args->calibration_given && !args->calibrate_given
+  && (dcm300->calib = calib_create(args->calibration_arg)) == NULL)
+    return 1;
+  /* no map yet is fine */
+  dcm300->defect = NULL;
+  if(dcm300->calib)
+    dcm300->defect = defect_open(args->calibration_arg);
+  if(args->pipeline_given && args->queue_depth_arg < 1)
+  {
+    fprintf(stderr, "queue depth must be at least 1\n");
+    return 1;
+  }
+  dcm300->pipeline_depth = args->pipeline_given ? args->queue_depth_arg : 0;
+  /* JPEG or PNG by extension of the output file */
+  if(args->output_given && !args->all_given)
+  {
+    dcm300->output = open(args->output_arg, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if(dcm300->output < 0)
+    {
+      perror(args->output_arg);
+      return 1;
+    }
+    if(!dcm300->raw && encode_format(args->output_arg) != ENCODE_PNM)
+    {
+      dcm300->encoder = encode_create(encode_format(args->output_arg), args->quality_arg);
+      if(dcm300->encoder == NULL)
+      {
+        fprintf(stderr, "%s: can't create encoder\n", args->output_arg);
+        return 1;
+      }
+    }
+  }
+
+  dcm300->overlay = NULL;
+  if(args->objective_given)
+  {
+    dcm300->overlay = overlay_create(args->objective_arg);
+    if(dcm300->overlay == NULL)
+      return 1;
+  }
+
+  /* bulk must be whole usb packets, ring grows to fit it */
+  if(dcm300->bulk < USBFS_PACKET || dcm300->bulk % USBFS_PACKET != 0)
+  {
+    fprintf(stderr, "bulk size must be multiple of %d\n", USBFS_PACKET);
+    return 1;
+  }
+
+  dcm300->stats = NULL;
+  if(args->stats_given)
+  {
+    int stats_fd = STDERR_FILENO;
+
+    if(args->stats_file_given)
+      stats_fd = open(args->stats_file_arg, O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if(stats_fd < 0 || (dcm300->stats = stats_create(stats_fd)) == NULL)
+    {
+      perror("can't open stats file");
+      return 1;
+    }
+  }
+
+  /* every camera with these settings, each into its own file
+  ** and with its own stats line
+  */
+  if(args->all_given)
+  {
+    result = multi_capture(dcm300, args->output_arg, args->quality_arg,
+                           args->objective_given ? args->objective_arg : NULL);
+    stats_destroy(dcm300->stats);
+    return result ? 1 : 0;
+  }
+
+  /* thin client, daemon has the camera open and warm */
+  if(args->socket_given && !args->daemon_given)
+  {
+    result = dcm300_client(dcm300, args->socket_arg);
+    if(result <= 0)
+      return result ? 1 : 0;
+    result = 0;
+  }
 
   fd = dcm300_open(dcm300);
 
@@ -82,9 +226,25 @@ int main(int argc, char **argv)
     return 1;
   }
 
-  dcm300_get_image(dcm300);
+  if(args->calibrate_given)
+    result = calib_capture(dcm300, args->calibration_arg, calib_type(args->calibrate_arg));
+  else if(args->daemon_given)
+    result = dcm300_daemon(dcm300, args->socket_given ? args->socket_arg : NULL);
+  else if(args->preview_given)
+    result = dcm300_preview(dcm300, args->preview_arg);
+  else
+    result = dcm300_get_image(dcm300) || dcm300->output_error ? -1 : 0;
 
+  if(dcm300->stats)
+    stats_report(dcm300->stats);
   dcm300_close(dcm300);
+  stats_destroy(dcm300->stats);
+  encode_destroy(dcm300->encoder);
+  overlay_destroy(dcm300->overlay);
+  meter_destroy(dcm300->meter);
+  stack_destroy(dcm300->stack);
+  calib_destroy(dcm300->calib);
+  defect_close(dcm300->defect);
   
-  return 0;
+  return result ? 1 : 0;
 }
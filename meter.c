@@ -0,0 +1,181 @@
+/* meter.c
+**
+** Auto exposure and white balance from per bayer
+** position histograms of the streamed raw image
+**
+** License: GPL
+**
+*/
+#include "dcm300.h"
+#include "meter.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+struct meter *meter_create(void)
+{
+  return calloc(1, sizeof(struct meter));
+}
+
+void meter_destroy(struct meter *m)
+{
+  free(m);
+}
+
+/* start metering a new frame */
+void meter_reset(struct meter *m, int width, int height)
+{
+  memset(m, 0, sizeof(*m));
+  m->width = width;
+  m->height = height;
+}
+
+/* data holds len bytes of the stream from image offset pos.
+** header (negative pos) and footer bytes are skipped
+*/
+void meter_add(struct meter *m, int pos, const u8 *data, int len)
+{
+  int p, stop, row, col, n, i;
+  u32 *h;
+  const u8 *s;
+
+  p = pos < 0 ? 0 : pos;
+  stop = pos + len;
+  if(stop > m->width * m->height)
+    stop = m->width * m->height;
+  for(; p < stop; p += n)
+  {
+    row = p / m->width;
+    col = p % m->width;
+    n = m->width - col;
+    if(n > stop - p)
+      n = stop - p;
+    /* R G R G ... or G B G B ... */
+    h = m->histogram[(row & 1) * 2];
+    s = data + (p - pos);
+    for(i = 0; i < n; i++)
+      h[((col + i) & 1) * 256 + s[i]]++;
+    m->pixels += n;
+  }
+}
+
+/* exposure for the next frame: the brightest pixels
+** (METER_PERCENTILE) should reach METER_TARGET.
+** Returns exposure unchanged when it is within 10%
+*/
+int meter_exposure(struct meter *m, int exposure)
+{
+  u64 count = 0, clipped = 0, rank;
+  int v, c, bright, next;
+  double ratio;
+
+  if(m->pixels == 0)
+    return exposure;
+  rank = (m->pixels * METER_PERCENTILE + 999) / 1000;
+  bright = 255;
+  for(v = 0; v < 256; v++)
+  {
+    for(c = 0; c < 4; c++)
+    {
+      count += m->histogram[c][v];
+      if(v >= METER_CLIP)
+        clipped += m->histogram[c][v];
+    }
+    if(count >= rank && bright == 255)
+      bright = v;
+  }
+  /* saturated highlights tell only that it's too bright */
+  if(bright >= METER_CLIP)
+    ratio = 0.5;
+  else
+    ratio = (double) METER_TARGET / (bright > 0 ? bright : 1);
+  if(ratio > 4)
+    ratio = 4;
+  next = exposure * ratio + 0.5;
+  if(next < METER_EXPOSURE_MIN)
+    next = METER_EXPOSURE_MIN;
+  if(next > METER_EXPOSURE_MAX)
+    next = METER_EXPOSURE_MAX;
+  if(verbose)
+    fprintf(stderr, "meter: %d%% at %d, %.1f%% clipped, exposure %d -> %d\n",
+      METER_PERCENTILE / 10, bright, 100.0 * clipped / m->pixels, exposure, next);
+  if(abs(next - exposure) * 10 <= exposure)
+    return exposure;
+  return next;
+}
+
+int meter_wb_mode(char *name)
+{
+  if(strcmp(name, "brightest") == 0)
+    return METER_BRIGHTEST;
+  return METER_GRAY_WORLD;
+}
+
+/* mean level of channel c without saturated pixels:
+** whole channel, or only its brightest METER_BRIGHT
+*/
+static double meter_level(struct meter *m, int c, int mode)
+{
+  u64 n = 0, sum = 0, take, want = 0;
+  int v;
+
+  if(mode == METER_BRIGHTEST)
+  {
+    for(v = 0; v < METER_CLIP; v++)
+      want += m->histogram[c][v];
+    want = (want * METER_BRIGHT + 999) / 1000;
+  }
+  for(v = METER_CLIP - 1; v >= 0; v--)
+  {
+    take = m->histogram[c][v];
+    if(mode == METER_BRIGHTEST && n + take > want)
+      take = want - n;
+    n += take;
+    sum += take * v;
+    if(mode == METER_BRIGHTEST && n >= want)
+      break;
+  }
+  return n ? (double) sum / n : 0;
+}
+
+static int meter_gain(s8 *gain, double level, double reference)
+{
+  int g, delta;
+
+  if(level < 1 || reference < 1)
+    return 0;
+  delta = lrint(METER_GAIN_STEP * log2(reference / level));
+  if(abs(delta) < METER_GAIN_SETTLED)
+    return 0;
+  g = *gain + delta;
+  if(g < -127)
+    g = -127;
+  if(g > 127)
+    g = 127;
+  if(g == *gain)
+    return 0;
+  *gain = g;
+  return 1;
+}
+
+/* bring red and blue to the level of green for the next
+** frame. Returns 1 when gains were changed, 0 when settled
+*/
+int meter_whitebalance(struct meter *m, int mode, s8 *red, s8 *green, s8 *blue)
+{
+  double r, g, b;
+  int changed;
+
+  if(m->pixels == 0)
+    return 0;
+  r = meter_level(m, METER_R, mode);
+  g = (meter_level(m, METER_GR, mode) + meter_level(m, METER_GB, mode)) / 2;
+  b = meter_level(m, METER_B, mode);
+  changed = meter_gain(red, r, g);
+  changed |= meter_gain(blue, b, g);
+  if(verbose)
+    fprintf(stderr, "meter: %s R %.1f G %.1f B %.1f, gains %d %d %d\n",
+      mode == METER_BRIGHTEST ? "brightest" : "gray world", r, g, b, *red, *green, *blue);
+  return changed;
+}
@@ -0,0 +1,43 @@
+#ifndef METER_H
+#define METER_H
+#include "binarytype.h"
+
+/* exposure and white balance metering from the raw bayer
+** stream. Per bayer position histograms are gathered while
+** bytes arrive, no separate pass over the image
+*/
+
+#define METER_R  0
+#define METER_GR 1 /* green on red row */
+#define METER_GB 2 /* green on blue row */
+#define METER_B  3
+
+#define METER_EXPOSURE_MIN 20  /* stable exposure range of the camera */
+#define METER_EXPOSURE_MAX 420
+#define METER_PERCENTILE   990 /* per mille of pixels placed at... */
+#define METER_TARGET       200 /* ...this level */
+#define METER_CLIP         250 /* saturated */
+#define METER_ROUNDS       4   /* tiny frames to converge at most */
+
+/* white balance modes */
+#define METER_GRAY_WORLD   0 /* mean of the scene is gray */
+#define METER_BRIGHTEST    1 /* brightest pixels are white */
+#define METER_BRIGHT       20  /* per mille of a channel that is "brightest" */
+#define METER_GAIN_STEP    32  /* gain units for a factor 2, gain curve is unknown */
+#define METER_GAIN_SETTLED 2   /* smaller gain corrections are not made */
+
+struct meter {
+  int width, height; /* bayer pixels of the metered frame */
+  u64 pixels; /* samples so far */
+  u32 histogram[4][256]; /* METER_R ... METER_B */
+};
+
+struct meter *meter_create(void);
+void meter_reset(struct meter *m, int width, int height);
+void meter_add(struct meter *m, int pos, const u8 *data, int len);
+int meter_exposure(struct meter *m, int exposure);
+int meter_wb_mode(char *name);
+int meter_whitebalance(struct meter *m, int mode, s8 *red, s8 *green, s8 *blue);
+void meter_destroy(struct meter *m);
+
+#endif
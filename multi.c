@@ -0,0 +1,251 @@
+/* multi.c
+**
+** Several cameras: listing by port id and
+** parallel snapshot on all of them
+**
+** License: GPL
+**
+*/
+#include "dcm300.h"
+#include "multi.h"
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+
+/* attached cameras on stdout, one per line */
+int multi_list(void)
+{
+  struct dcm300_camera list[DCM300_CAMERAS];
+  int i, n;
+
+  n = dcm300_enumerate(list, DCM300_CAMERAS);
+  if(n < 0)
+  {
+    perror("can't list cameras");
+    return -1;
+  }
+  for(i = 0; i < n; i++)
+    printf("%-12s %03d:%03d %4d Mbit/s\n", list[i].id, list[i].bus, list[i].dev, list[i].speed);
+  return 0;
+}
+
+/* scope.jpg of camera 3-1.2 is scope-3-1.2.jpg */
+static void multi_output_name(char *name, int size, char *output, char *id)
+{
+  char *dot = strrchr(output, '.');
+
+  if(dot == NULL || strchr(dot, '/'))
+    dot = output + strlen(output);
+  snprintf(name, size, "%.*s-%s%s", (int) (dot - output), output, id, dot);
+}
+
+/* lock the buffers the transfer thread writes into,
+** no page fault in the middle of a bulk: those of the
+** session and the URBs
+*/
+static int multi_pin(struct dcm300 *dcm300)
+{
+  if(dcm300_session_pin(dcm300->session))
+    return -1;
+  if(dcm300->queue && mlock(dcm300->queue->buffer, dcm300->queue->depth * dcm300->queue->size))
+    return -1;
+  return 0;
+}
+
+/* clone of the command line settings for one camera,
+** everything a snapshot changes is its own
+*/
+static int multi_open(struct multi_camera *m, struct dcm300 *settings,
+                      char *output, int quality, char *objective)
+{
+  struct dcm300 *dcm300;
+  int fd;
+
+  dcm300 = m->dcm300 = malloc(sizeof(*dcm300));
+  if(dcm300 == NULL)
+    return -1;
+  *dcm300 = *settings;
+  dcm300->name = m->camera.id;
+  dcm300->quiet = 1;
+  dcm300->record_name = NULL;
+  dcm300->stats = NULL;
+  /* histograms of its own, reported with the camera id */
+  if(settings->stats)
+  {
+    fd = dup(settings->stats->fd);
+    if(fd < 0 || (dcm300->stats = stats_create(fd)) == NULL)
+    {
+      if(fd >= 0)
+        close(fd);
+      free(dcm300);
+      m->dcm300 = NULL;
+      return -1;
+    }
+    dcm300->stats->camera = m->camera.id;
+  }
+  dcm300->t_startup = 0;
+  dcm300->encoder = NULL;
+  dcm300->overlay = NULL;
+  dcm300->meter = NULL;
+  dcm300->usb_dev_handle = NULL;
+  dcm300->queue = NULL;
+  dcm300->usbfs = -1;
+  multi_output_name(m->output, sizeof(m->output), output, m->camera.id);
+  dcm300->output = open(m->output, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if(dcm300->output < 0)
+  {
+    perror(m->output);
+    stats_destroy(dcm300->stats);
+    free(dcm300);
+    m->dcm300 = NULL;
+    return -1;
+  }
+  if(!dcm300->raw && encode_format(m->output) != ENCODE_PNM
+  && (dcm300->encoder = encode_create(encode_format(m->output), quality)) == NULL)
+  {
+    fprintf(stderr, "%s: can't create encoder\n", m->output);
+    return -1;
+  }
+  if(objective && (dcm300->overlay = overlay_create(objective)) == NULL)
+    return -1;
+  if((dcm300->autoexposure || dcm300->whitebalance)
+  && (dcm300->meter = meter_create()) == NULL)
+    return -1;
+  if(dcm300_open(dcm300) < 0)
+  {
+    fprintf(stderr, "%s: can't open camera\n", m->camera.id);
+    return -1;
+  }
+  m->pinned = multi_pin(m->dcm300) == 0;
+  if(!m->pinned)
+    fprintf(stderr, "%s: can't lock buffers in memory: %s\n", m->camera.id, strerror(errno));
+  return 0;
+}
+
+static void multi_close(struct multi_camera *m)
+{
+  struct dcm300 *dcm300 = m->dcm300;
+
+  if(dcm300 == NULL)
+    return;
+  /* the session unlocks its own buffers */
+  if(m->pinned && dcm300->queue)
+    munlock(dcm300->queue->buffer, dcm300->queue->depth * dcm300->queue->size);
+  dcm300_close(dcm300);
+  close(dcm300->output);
+  encode_destroy(dcm300->encoder);
+  overlay_destroy(dcm300->overlay);
+  meter_destroy(dcm300->meter);
+  stats_destroy(dcm300->stats);
+  free(dcm300);
+  m->dcm300 = NULL;
+}
+
+static void *multi_thread(void *arg)
+{
+  struct multi_camera *m = arg;
+
+  pthread_rwlock_rdlock(m->start);
+  pthread_rwlock_unlock(m->start);
+  m->t_start = dcm300_ns();
+  m->result = dcm300_get_image(m->dcm300);
+  if(m->dcm300->output_error)
+    m->result = -1;
+  m->t_end = dcm300_ns();
+  return NULL;
+}
+
+/*
+** snapshot on all attached cameras with the settings of
+** dcm300, each into output with the camera id added.
+** Cameras are opened by port id one after the other,
+** then captured in parallel.
+** Prints time and throughput of each camera and the total
+*/
+int multi_capture(struct dcm300 *dcm300, char *output, int quality, char *objective)
+{
+  struct dcm300_camera list[DCM300_CAMERAS];
+  struct multi_camera *multi;
+  pthread_rwlock_t start = PTHREAD_RWLOCK_INITIALIZER;
+  u64 t_start, t_end;
+  double bytes, total = 0;
+  int i, n, running = 0, failed = 0;
+
+  n = dcm300_enumerate(list, DCM300_CAMERAS);
+  if(n <= 0)
+  {
+    fprintf(stderr, "no camera found\n");
+    return -1;
+  }
+  multi = calloc(n, sizeof(*multi));
+  if(multi == NULL)
+    return -1;
+
+  for(i = 0; i < n; i++)
+  {
+    multi[i].camera = list[i];
+    multi[i].start = &start;
+    multi[i].result = -1;
+    if(multi_open(&multi[i], dcm300, output, quality, objective))
+    {
+      multi_close(&multi[i]);
+      failed++;
+    }
+  }
+
+  /* threads wait for the read lock, unlock starts them all */
+  pthread_rwlock_wrlock(&start);
+  for(i = 0; i < n; i++)
+    if(multi[i].dcm300)
+    {
+      multi[i].running = pthread_create(&multi[i].thread, NULL, multi_thread, &multi[i]) == 0;
+      if(multi[i].running)
+        running++;
+      else
+      {
+        fprintf(stderr, "%s: can't start capture thread\n", multi[i].camera.id);
+        multi_close(&multi[i]);
+        failed++;
+      }
+    }
+  if(running == 0)
+  {
+    pthread_rwlock_unlock(&start);
+    free(multi);
+    return -1;
+  }
+  t_start = dcm300_ns();
+  pthread_rwlock_unlock(&start);
+  for(i = 0; i < n; i++)
+    if(multi[i].running)
+      pthread_join(multi[i].thread, NULL);
+  t_end = dcm300_ns();
+
+  for(i = 0; i < n; i++)
+  {
+    if(!multi[i].running)
+      continue;
+    bytes = multi[i].dcm300->bytes;
+    total += bytes;
+    if(multi[i].result)
+      failed++;
+    fprintf(stderr, "%-12s %03d:%03d %s %.0f bytes in %.1f ms, %.1f MB/s%s\n",
+      multi[i].camera.id, multi[i].camera.bus, multi[i].camera.dev, multi[i].output,
+      bytes, (multi[i].t_end - multi[i].t_start) * 1e-6,
+      bytes * 1e3 / (multi[i].t_end - multi[i].t_start),
+      multi[i].result ? " failed" : "");
+    if(multi[i].dcm300->stats)
+      stats_report(multi[i].dcm300->stats);
+    multi_close(&multi[i]);
+  }
+  fprintf(stderr, "%d cameras: %.0f bytes in %.1f ms, %.1f MB/s\n",
+    running, total, (t_end - t_start) * 1e-6, total * 1e3 / (t_end - t_start));
+  free(multi);
+  return failed ? -1 : 0;
+}
@@ -0,0 +1,33 @@
+#ifndef MULTI_H
+#define MULTI_H
+#include <pthread.h>
+#include <limits.h>
+#include "binarytype.h"
+#include "libdcm300.h"
+
+/* snapshot on every attached camera at once. Each camera
+** has its own struct dcm300 cloned from the command line
+** settings, its own output file and its own transfer
+** thread. Threads are released together so the requests
+** go out at the same moment, cameras on different root
+** controllers then transfer in parallel
+*/
+
+struct dcm300;
+
+struct multi_camera {
+  struct dcm300_camera camera;
+  struct dcm300 *dcm300;
+  char output[PATH_MAX]; /* output name with the camera id */
+  pthread_t thread;
+  pthread_rwlock_t *start; /* write locked until all threads may begin */
+  int running; /* 1-thread was started */
+  int pinned; /* 1-buffers locked in memory */
+  int result; /* of dcm300_get_image() */
+  u64 t_start, t_end; /* snapshot time */
+};
+
+int multi_list(void);
+int multi_capture(struct dcm300 *dcm300, char *output, int quality, char *objective);
+
+#endif
@@ -0,0 +1,189 @@
+/* overlay.c
+**
+** Scale bar and label strip rendered with the
+** built-in bitmap font, written as the last rows
+** of the output stream
+**
+** License: GPL
+**
+*/
+#include "overlay.h"
+#include "font.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* bar lengths measured with a stage micrometer,
+** the same bars tools/snapshot_f*.sh used to draw
+*/
+struct overlay_profile overlay_profiles[] = {
+  { "4x",  662, "1 mm" },
+  { "10x", 867, "500 µm" },
+  { "40x", 674, "100 µm" },
+  { "60x", 518, "50 µm" },
+  { NULL, 0, NULL },
+};
+
+/* profile name, or custom "NAME:PIXELS:LABEL" */
+struct overlay *overlay_create(char *spec)
+{
+  struct overlay *o;
+  struct overlay_profile *p;
+  char *pixels, *label;
+
+  o = calloc(1, sizeof(*o));
+  if(o == NULL)
+    return NULL;
+  for(p = overlay_profiles; p->name; p++)
+    if(strcmp(p->name, spec) == 0)
+    {
+      o->profile = *p;
+      return o;
+    }
+  o->spec = strdup(spec);
+  if(o->spec == NULL
+  || (pixels = strchr(o->spec, ':')) == NULL
+  || (label = strchr(pixels + 1, ':')) == NULL)
+  {
+    fprintf(stderr, "overlay: unknown objective %s, use NAME:PIXELS:LABEL\n", spec);
+    overlay_destroy(o);
+    return NULL;
+  }
+  *pixels++ = 0;
+  *label++ = 0;
+  o->profile.name = o->spec;
+  o->profile.pixels = atoi(pixels);
+  o->profile.label = label;
+  if(o->profile.pixels <= 0)
+  {
+    fprintf(stderr, "overlay: bar length must be positive\n");
+    overlay_destroy(o);
+    return NULL;
+  }
+  return o;
+}
+
+void overlay_destroy(struct overlay *o)
+{
+  if(o == NULL)
+    return;
+  free(o->spec);
+  free(o->strip);
+  free(o);
+}
+
+/* glyph of next UTF-8 character, '?' for ones not in the font */
+static int overlay_glyph(const unsigned char **s)
+{
+  int c = *(*s)++;
+
+  if(c >= FONT_FIRST && c < FONT_FIRST + FONT_MU)
+    return c - FONT_FIRST;
+  if(c == 0xc2 && **s == 0xb5)
+  {
+    (*s)++;
+    return FONT_MU;
+  }
+  while((**s & 0xc0) == 0x80)
+    (*s)++;
+  return '?' - FONT_FIRST;
+}
+
+static int overlay_length(const char *text)
+{
+  const unsigned char *s = (const unsigned char *) text;
+  int n = 0;
+
+  while(*s)
+  {
+    overlay_glyph(&s);
+    n++;
+  }
+  return n;
+}
+
+static void overlay_fill(struct overlay *o, int x0, int x1, int y0, int y1)
+{
+  int y;
+
+  if(x0 < 0)
+    x0 = 0;
+  if(x1 > o->width)
+    x1 = o->width;
+  if(x1 <= x0)
+    return;
+  for(y = y0; y < y1; y++)
+    memset(o->strip + 3 * (y * o->width + x0), 0, 3 * (x1 - x0));
+}
+
+/* draw text magnified zoom times, returns x after it */
+static int overlay_text(struct overlay *o, int x, const char *text, int zoom)
+{
+  const unsigned char *s = (const unsigned char *) text;
+  const u16 *g;
+  int gx, gy;
+
+  while(*s)
+  {
+    g = font_glyph[overlay_glyph(&s)];
+    for(gy = 0; gy < FONT_HEIGHT; gy++)
+      for(gx = 0; gx < FONT_WIDTH; gx++)
+        if(g[gy] & (0x8000 >> gx))
+          overlay_fill(o, x + gx * zoom, x + (gx + 1) * zoom, gy * zoom, (gy + 1) * zoom);
+    x += FONT_WIDTH * zoom;
+  }
+  return x;
+}
+
+/* render strip for output width, scale 2 for binned output */
+static int overlay_render(struct overlay *o, int width, int scale)
+{
+  char left[256];
+  int bar, zoom, cell, total, x, i, n;
+
+  bar = (o->profile.pixels + scale / 2) / scale;
+  snprintf(left, sizeof(left), "%s%s0", o->profile.name, o->profile.name[0] ? " " : "");
+  /* a character about as wide as a bar segment */
+  zoom = (bar / 10 + FONT_WIDTH / 2) / FONT_WIDTH;
+  if(zoom < 1)
+    zoom = 1;
+  /* left text, space with the tick, bar, space, label */
+  n = overlay_length(left) + 2 + overlay_length(o->profile.label);
+  while(zoom > 1 && n * FONT_WIDTH * zoom + bar > width)
+    zoom--;
+  cell = FONT_WIDTH * zoom;
+  total = n * cell + bar;
+
+  free(o->strip);
+  o->width = width;
+  o->scale = scale;
+  o->rows = FONT_HEIGHT * zoom;
+  o->strip = malloc(3 * o->rows * width);
+  if(o->strip == NULL)
+  {
+    o->width = o->rows = 0;
+    return -1;
+  }
+  memset(o->strip, 255, 3 * o->rows * width);
+
+  x = total < width ? (width - total) / 2 : 0;
+  x = overlay_text(o, x, left, zoom) + cell;
+  /* tick at the start of the bar, right eighth of a cell */
+  overlay_fill(o, x - cell / 8, x, 0, o->rows);
+  /* lower half and full height segments, alternating */
+  for(i = 0; i < 10; i++)
+    overlay_fill(o, x + i * bar / 10, x + (i + 1) * bar / 10,
+      i & 1 ? 0 : o->rows / 2, o->rows);
+  x += bar + cell;
+  overlay_text(o, x, o->profile.label, zoom);
+  return 0;
+}
+
+/* height of the strip for this output, renders it if not cached */
+int overlay_rows(struct overlay *o, int width, int scale)
+{
+  if(o->width != width || o->scale != scale)
+    if(overlay_render(o, width, scale))
+      return 0;
+  return o->rows;
+}
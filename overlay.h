@@ -0,0 +1,33 @@
+#ifndef OVERLAY_H
+#define OVERLAY_H
+#include "binarytype.h"
+
+/* scale bar strip appended below the image:
+**   NAME 0|_#_#_#_#_# LABEL
+** bar has exact length of the profile, text is drawn
+** with the built-in font about as wide as a bar segment.
+** Strip is rendered once per output width and cached.
+*/
+
+struct overlay_profile {
+  char *name; /* objective, left of the bar */
+  int pixels; /* bar length in sensor pixels (full 2048 resolution) */
+  char *label; /* length the bar represents, right of the bar */
+};
+
+struct overlay {
+  struct overlay_profile profile;
+  char *spec; /* copy of custom profile string */
+  int width; /* output width the strip is rendered for, 0-none yet */
+  int scale; /* sensor pixels per output pixel */
+  int rows; /* strip height */
+  u8 *strip; /* rows*width RGB pixels */
+};
+
+extern struct overlay_profile overlay_profiles[];
+
+struct overlay *overlay_create(char *spec);
+int overlay_rows(struct overlay *o, int width, int scale);
+void overlay_destroy(struct overlay *o);
+
+#endif
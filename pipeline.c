@@ -0,0 +1,276 @@
+/* pipeline.c
+**
+** Reader, conversion and writer of a session on separate
+** threads joined by lock-free single producer single
+** consumer queues, so a slow output never delays USB reads
+**
+** License: GPL
+**
+*/
+#include "session.h"
+#include "pipeline.h"
+#include <sys/mman.h>
+#include <time.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void pipeline_poll(void)
+{
+  struct timespec t = { 0, PIPELINE_POLL_NS };
+
+  nanosleep(&t, NULL);
+}
+
+/* bayer ring must be sized for depth+1 bulks, see dcm300_session_create() */
+struct pipeline *pipeline_create(struct dcm300_session *session)
+{
+  struct pipeline *p;
+  int depth = session->config.depth;
+
+  p = calloc(1, sizeof(*p));
+  if(p == NULL)
+    return NULL;
+  p->depth = depth;
+  p->bulk = session->config.bulk;
+  p->scratch = malloc(p->bulk);
+  /* full resolution RGB is 3 bytes per bayer byte */
+  if(p->scratch == NULL
+  || spsc_init(&p->chunks, depth, sizeof(struct pipeline_chunk))
+  || ring_create(&p->out, 3 * depth * p->bulk))
+  {
+    pipeline_destroy(p);
+    return NULL;
+  }
+  p->counters.queue_depth = spsc_capacity(&p->chunks);
+  p->counters.out_size = p->out.size;
+  return p;
+}
+
+/* both halves of the out ring and the scratch bulk */
+int pipeline_pin(struct pipeline *p)
+{
+  if(p == NULL)
+    return 0;
+  if(mlock(p->out.base, 2 * p->out.size) || mlock(p->scratch, p->bulk))
+    return -1;
+  return 0;
+}
+
+/* the out ring is unlocked when it is unmapped */
+void pipeline_unpin(struct pipeline *p)
+{
+  if(p)
+    munlock(p->scratch, p->bulk);
+}
+
+void pipeline_destroy(struct pipeline *p)
+{
+  if(p == NULL)
+    return;
+  spsc_destroy(&p->chunks);
+  ring_destroy(&p->out);
+  free(p->scratch);
+  free(p);
+}
+
+/* black for bytes that never arrived */
+static void pipeline_fill(struct dcm300_session *session, int len)
+{
+  memset(ring_at(&session->bayer, session->bayer_read), 0, len);
+  dcm300_session_process(session, len);
+}
+
+static void *pipeline_demosaic(void *arg)
+{
+  struct dcm300_session *session = arg;
+  struct pipeline *p = session->pipeline;
+  struct pipeline_chunk c;
+  int done, len;
+
+  for(;;)
+  {
+    /* done before pop: an empty queue after done is really empty */
+    done = atomic_load_explicit(&p->reader_done, memory_order_acquire);
+    if(spsc_pop(&p->chunks, &c) == 0)
+    {
+      /* hole of dropped bulks lies inside the window the reader checked */
+      if(c.pos > session->bayer_read)
+        pipeline_fill(session, c.pos - session->bayer_read);
+      dcm300_session_process(session, c.len);
+      atomic_store_explicit(&p->consumed, dcm300_session_needed(session), memory_order_release);
+      continue;
+    }
+    if(done)
+      break;
+    pipeline_poll();
+  }
+  /* image must have full size even if its last bulks were dropped */
+  if(p->frame_drops)
+    while(session->bayer_read < session->bayer_end)
+    {
+      len = session->bayer_end - session->bayer_read;
+      if(len > p->bulk)
+        len = p->bulk;
+      pipeline_fill(session, len);
+    }
+  atomic_store_explicit(&p->demosaic_done, 1, memory_order_release);
+  return NULL;
+}
+
+static void *pipeline_writer(void *arg)
+{
+  struct dcm300_session *session = arg;
+  struct pipeline *p = session->pipeline;
+  unsigned int head, tail;
+  int done, n;
+
+  tail = atomic_load_explicit(&p->out_tail, memory_order_relaxed);
+  for(;;)
+  {
+    done = atomic_load_explicit(&p->demosaic_done, memory_order_acquire);
+    head = atomic_load_explicit(&p->out_head, memory_order_acquire);
+    if(head != tail)
+    {
+      n = head - tail;
+      /* keep draining so conversion doesn't wait forever */
+      if(!atomic_load_explicit(&p->write_error, memory_order_relaxed)
+      && session->cbfunc(session->param, n, ring_at(&p->out, tail)) < 0)
+        atomic_store_explicit(&p->write_error, 1, memory_order_release);
+      tail += n;
+      atomic_store_explicit(&p->out_tail, tail, memory_order_release);
+      continue;
+    }
+    if(done)
+      break;
+    pipeline_poll();
+  }
+  return NULL;
+}
+
+/* start conversion and writer threads for a frame,
+** after bayer_read/bayer_from of the session were set
+*/
+int pipeline_start(struct dcm300_session *session)
+{
+  struct pipeline *p = session->pipeline;
+
+  p->read_pos = session->bayer_read;
+  atomic_store(&p->consumed, dcm300_session_needed(session));
+  atomic_store(&p->reader_done, 0);
+  atomic_store(&p->demosaic_done, 0);
+  atomic_store(&p->out_head, 0);
+  atomic_store(&p->out_tail, 0);
+  atomic_store(&p->write_error, 0);
+  p->frame_drops = 0;
+  /* conversion hands rows to the writer from its first bulk on */
+  session->pipelined = 1;
+  if(pthread_create(&p->demosaic, NULL, pipeline_demosaic, session))
+  {
+    session->pipelined = 0;
+    return -1;
+  }
+  if(pthread_create(&p->writer, NULL, pipeline_writer, session))
+  {
+    atomic_store(&p->reader_done, 1);
+    pthread_join(p->demosaic, NULL);
+    session->pipelined = 0;
+    return -1;
+  }
+  return 0;
+}
+
+/*
+** read next bulk straight into the ring and queue it for
+** conversion. Never waits for conversion: without room the
+** bulk is still read, to keep the camera streaming, and
+** dropped. Only a lossless source is read at its pace
+*/
+int pipeline_read(struct dcm300_session *session, int want)
+{
+  struct pipeline *p = session->pipeline;
+  struct pipeline_chunk c;
+  unsigned int queued;
+  int room, len;
+
+  for(;;)
+  {
+    queued = spsc_count(&p->chunks);
+    room = queued < spsc_capacity(&p->chunks)
+        && p->read_pos + want - atomic_load_explicit(&p->consumed, memory_order_acquire)
+           <= session->bayer.size;
+    /* a file can't overrun, it may wait */
+    if(room || !session->config.lossless)
+      break;
+    pipeline_poll();
+  }
+  len = session->t.read(session->t.ctx, room ? ring_at(&session->bayer, p->read_pos) : p->scratch, want);
+  if(len <= 0)
+    return len;
+  if(room)
+  {
+    c.pos = p->read_pos;
+    c.len = len;
+    spsc_push(&p->chunks, &c);
+    p->counters.chunks++;
+    if((int) queued + 1 > p->counters.queue_max)
+      p->counters.queue_max = queued + 1;
+  }
+  else
+  {
+    p->frame_drops++;
+    p->counters.dropped_chunks++;
+    p->counters.dropped_bytes += len;
+  }
+  p->read_pos += len;
+  return len;
+}
+
+/* conversion thread: copy output bytes for the writer,
+** wait while the writer is behind
+*/
+int pipeline_output(struct dcm300_session *session, u8 *data, int len)
+{
+  struct pipeline *p = session->pipeline;
+  unsigned int head, used;
+  int n;
+  u64 t;
+
+  head = atomic_load_explicit(&p->out_head, memory_order_relaxed);
+  while(len > 0)
+  {
+    used = head - atomic_load_explicit(&p->out_tail, memory_order_acquire);
+    if(used == (unsigned int) p->out.size)
+    {
+      t = dcm300_ns();
+      p->counters.waits++;
+      do
+        pipeline_poll();
+      while(head - atomic_load_explicit(&p->out_tail, memory_order_acquire)
+            == (unsigned int) p->out.size);
+      p->counters.wait_ns += dcm300_ns() - t;
+      continue;
+    }
+    n = p->out.size - used;
+    if(n > len)
+      n = len;
+    memcpy(ring_at(&p->out, head), data, n);
+    head += n;
+    atomic_store_explicit(&p->out_head, head, memory_order_release);
+    if((int) (used + n) > p->counters.out_max)
+      p->counters.out_max = used + n;
+    data += n;
+    len -= n;
+  }
+  return atomic_load_explicit(&p->write_error, memory_order_acquire) ? -1 : 0;
+}
+
+/* reader has read the whole frame, wait until it is written */
+int pipeline_finish(struct dcm300_session *session)
+{
+  struct pipeline *p = session->pipeline;
+
+  atomic_store_explicit(&p->reader_done, 1, memory_order_release);
+  pthread_join(p->demosaic, NULL);
+  pthread_join(p->writer, NULL);
+  return atomic_load_explicit(&p->write_error, memory_order_acquire) ? -1 : 0;
+}
@@ -0,0 +1,59 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+#include <pthread.h>
+#include <stdatomic.h>
+#include "binarytype.h"
+#include "libdcm300.h"
+#include "ring.h"
+#include "spsc.h"
+
+/* three stage capture pipeline of a session:
+**
+**   reader (capturing thread) -> chunks -> conversion thread -> out -> writer thread
+**
+** reader reads bulks straight into the bayer ring and
+** queues their position. It never waits: when the ring or
+** the queue is full the bulk is read into scratch and
+** dropped, conversion fills the hole with black.
+** conversion runs the hooks and writes RGB into the out
+** byte ring and waits there when the writer is behind
+** (backpressure). The writer calls the row callback.
+*/
+
+#define PIPELINE_POLL_NS 20000 /* idle stage sleeps this long between polls */
+
+struct pipeline_chunk {
+  int pos; /* stream position of the bulk in the bayer ring */
+  int len;
+};
+
+struct pipeline {
+  int depth; /* bulks queued between reader and conversion */
+  int bulk; /* bytes of scratch */
+  int read_pos; /* reader's stream position */
+  atomic_int consumed; /* conversion no longer needs ring below this position */
+  atomic_int reader_done; /* reader has queued the last bulk of the frame */
+  atomic_int demosaic_done; /* conversion has produced the last byte of the frame */
+  atomic_int write_error; /* writer failed, output is discarded */
+  int frame_drops; /* bulks dropped in the current frame */
+  struct spsc chunks; /* reader -> conversion */
+  struct ring out; /* conversion -> writer bytes */
+  _Alignas(SPSC_CACHELINE) atomic_uint out_head; /* written by conversion */
+  _Alignas(SPSC_CACHELINE) atomic_uint out_tail; /* written by writer */
+  u8 *scratch; /* dropped bulks are read here */
+  pthread_t demosaic, writer;
+  struct dcm300_pipeline_stats counters;
+};
+
+struct dcm300_session;
+
+struct pipeline *pipeline_create(struct dcm300_session *session);
+int pipeline_pin(struct pipeline *p);
+void pipeline_unpin(struct pipeline *p);
+void pipeline_destroy(struct pipeline *p);
+int pipeline_start(struct dcm300_session *session);
+int pipeline_read(struct dcm300_session *session, int want);
+int pipeline_output(struct dcm300_session *session, u8 *data, int len);
+int pipeline_finish(struct dcm300_session *session);
+
+#endif
@@ -0,0 +1,64 @@
+/* ring.c
+**
+** Mirrored mapping circular buffer
+**
+** License: GPL
+**
+*/
+#define _GNU_SOURCE
+#include "ring.h"
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <stdio.h>
+#include <unistd.h>
+
+/* create ring of at least size bytes, rounded up to whole pages */
+int ring_create(struct ring *ring, int size)
+{
+  long page = sysconf(_SC_PAGESIZE);
+  u8 *base;
+  int fd;
+
+  ring->base = NULL;
+  ring->size = (size + page - 1) / page * page;
+
+  fd = memfd_create("dcm300-ring", MFD_CLOEXEC);
+  if(fd < 0)
+  {
+    perror("ring_create: memfd_create");
+    return -1;
+  }
+  if(ftruncate(fd, ring->size) < 0)
+  {
+    perror("ring_create: ftruncate");
+    close(fd);
+    return -1;
+  }
+  /* reserve address space for both copies, then map storage into each half */
+  base = mmap(NULL, 2 * ring->size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if(base == MAP_FAILED)
+  {
+    perror("ring_create: mmap");
+    close(fd);
+    return -1;
+  }
+  if(mmap(base, ring->size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED
+  || mmap(base + ring->size, ring->size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED)
+  {
+    perror("ring_create: mmap mirror");
+    munmap(base, 2 * ring->size);
+    close(fd);
+    return -1;
+  }
+  /* mappings keep the memory, descriptor is not needed anymore */
+  close(fd);
+  ring->base = base;
+  return 0;
+}
+
+void ring_destroy(struct ring *ring)
+{
+  if(ring->base)
+    munmap(ring->base, 2 * ring->size);
+  ring->base = NULL;
+}
@@ -0,0 +1,28 @@
+#ifndef RING_H
+#define RING_H
+#include "binarytype.h"
+
+/* circular buffer whose storage is mapped twice back-to-back,
+** so size bytes starting at any position are contiguous in memory
+** and rows can be processed through linear pointers
+*/
+struct ring {
+  u8 *base; /* 2*size bytes of address space */
+  int size; /* bytes of storage, multiple of page size */
+};
+
+int ring_create(struct ring *ring, int size);
+void ring_destroy(struct ring *ring);
+
+/* pointer to stream position pos, valid for size bytes.
+** Negative positions (the 64 byte header before the image)
+** lie just before position 0 for any size
+*/
+static inline u8 *ring_at(struct ring *ring, int pos)
+{
+  int i = pos % ring->size;
+
+  return ring->base + (i < 0 ? i + ring->size : i);
+}
+
+#endif
@@ -58,7 +58,7 @@
    . .
    . . - sane_start() : start image acquisition
    . .   - sane_get_parameters() : returns actual scan parameters
-   . .   - sane_read() : read image data (from pipe)
+   . .   - sane_read() : read image data (from ring buffer)
    . .
    . . - sane_cancel() : cancel operation
    . - sane_close() : close opened scanner device
@@ -86,7 +86,11 @@
 #include <time.h>
 
 #include <sys/types.h>
+#include <sys/eventfd.h>
 #include <unistd.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdatomic.h>
 #ifdef HAVE_LIBC_H
 # include <libc.h>		/* NeXTStep/OpenStep */
 #endif
@@ -95,12 +99,22 @@
 #include "sane/sanei_usb.h"
 #include "sane/saneopts.h"
 #include "sane/sanei_config.h"
-#include "sane/sanei_thread.h"
 #include "sane/sanei_backend.h"
 
+#include "libdcm300.h"
+#include "demosaic.h"
+#include "ring.h"
+
 typedef int (*dcm300_callback) (void *param, unsigned bytes, void *data);
 
 #define DEBUG 1
+/* image bytes between reader and sane_read: the largest
+** frame, full resolution RGB. The reader then never waits
+** for a slow frontend in the middle of the bulk reads, a
+** stall there makes the camera fail the transfer
+*/
+#define DCM300_RING (3 * DCM300_WIDTH * DCM300_HEIGHT)
+#define DCM300_POLL_NS 1000000 /* reader waits for room in the ring */
 #define MM_PER_INCH 1
 #define SCANNER_UNIT_TO_FIXED_MM(number) (number * MM_PER_INCH / 1)
 #define FIXED_MM_TO_SCANNER_UNIT(number) (number * 1 / MM_PER_INCH)
@@ -120,7 +134,7 @@ enum dcm300_option
 {
   OPT_NUM_OPTS = 0,
 
-/*  OPT_RESOLUTION, */
+  OPT_RESOLUTION,
   OPT_EXPOSURE,
   OPT_GAIN_RED,
   OPT_GAIN_GREEN,
@@ -148,20 +162,35 @@ struct dcm300_data
 {
   struct dcm300_data *next;
   char *devicename;
+  struct dcm300_camera camera; /* port id, empty if unknown */
+  char model[48];
 
   int sfd;
-  int pipe_r;
-  int pipe_w;
-  int reader_pid;
+  struct dcm300_session *session; /* capture on sfd, keeps the camera warm */
+
+  /* reader thread writes the image into the ring, sane_read()
+  ** copies it out. event_fd is readable while there is
+  ** something for sane_read(): data or the end of the scan
+  */
+  struct ring ring;
+  atomic_uint ring_head; /* written by reader */
+  atomic_uint ring_tail; /* written by sane_read */
+  int event_fd;
+  int non_blocking;
+  pthread_t reader;
+  int reader_running; /* 1-started and not joined */
+  atomic_int reader_done; /* 1-reader_status is valid */
+  atomic_int cancel; /* 1-reader should stop */
+  SANE_Status reader_status;
 
   int resolution;
   int exposure;
   int gain_red, gain_green, gain_blue;
   int mode;
 
-  time_t last_scan;
-
-  dcm300_rect request_pixel;
+  dcm300_rect request_pixel; /* TL/BR options, sensor pixels */
+  dcm300_rect sensor; /* requested from the camera, right/bottom exclusive */
+  int bin; /* sensor pixels per output pixel */
 #if 0
   int rounded_left;
   int rounded_top;
@@ -191,12 +220,13 @@ typedef struct detailed_calibration_data
 static struct dcm300_data *first_dev = 0;
 static struct dcm300_data **new_dev = &first_dev;
 static int num_devices = 0;
+/* pixels across the sensor width: full, 1/2, 1/4, 1/8 */
 static SANE_Int res_list[] =
-  { 1, 1 }; /* list: number of items, item1, ... */
+  { 4, 256, 512, 1024, 2048 }; /* list: number of items, item1, ... */
 static const SANE_Range range_x =
-  { 0, 1023, 1 }; /* range: min, max, quantization */
+  { 0, DCM300_WIDTH - 1, 1 }; /* range: min, max, quantization */
 static const SANE_Range range_y =
-  { 0, 767, 1 };
+  { 0, DCM300_HEIGHT - 1, 1 };
 static const SANE_Range range_exp =
   { 0, 2999, 1 };
 static const SANE_Range range_gain_red =
@@ -213,10 +243,33 @@ static char const *scan_mode_list[HP3500_TOTAL_SCANS + 1] = { 0 };
 
 static SANE_Status attachScanner (const char *name);
 static SANE_Status init_options (struct dcm300_data *scanner);
-static int reader_process (void *);
+static void *reader_thread (void *);
+static int dcm300_usb_write (void *ctx, u8 *data, int len);
+static int dcm300_usb_read (void *ctx, u8 *data, int len);
 static void calculateDerivedValues (struct dcm300_data *scanner);
 static void do_reset (struct dcm300_data *scanner);
 static void do_cancel (struct dcm300_data *scanner);
+static void do_release (struct dcm300_data *scanner);
+
+/* eventfd counter nonzero makes the select fd readable */
+static void
+dcm300_event_signal (struct dcm300_data *scanner)
+{
+  uint64_t one = 1;
+
+  if (write (scanner->event_fd, &one, sizeof (one)) < 0)
+    DBG (1, "eventfd write: %s\n", strerror (errno));
+}
+
+static void
+dcm300_event_clear (struct dcm300_data *scanner)
+{
+  uint64_t count;
+
+  /* EAGAIN when already clear */
+  if (read (scanner->event_fd, &count, sizeof (count)) < 0 && errno != EAGAIN)
+    DBG (1, "eventfd read: %s\n", strerror (errno));
+}
 
 /*
  * used by sane_get_devices
@@ -250,7 +303,6 @@ sane_init (SANE_Int * version_code, SANE_Auth_Callback authorize)
   DBG (10, "sane_init\n");
 
   sanei_usb_init ();
-  sanei_thread_init ();
 
   if (version_code)
     *version_code = SANE_VERSION_CODE (V_MAJOR, V_MINOR, 0);
@@ -340,7 +392,8 @@ sane_open (SANE_String_Const name, SANE_Handle * handle)
 
       for (dev = first_dev; dev; dev = dev->next)
 	{
-	  if (strcmp (dev->sane.name, name) == 0)
+	  if (strcmp (dev->sane.name, name) == 0
+	      || strcmp (dev->camera.id, name) == 0)
 	    {
 	      DBG (10, "sane_open: device %s found\n", name);
 	      scanner = (struct dcm300_data *) dev;
@@ -354,20 +407,36 @@ sane_open (SANE_String_Const name, SANE_Handle * handle)
       return SANE_STATUS_INVAL;
     }
 
+  /* preallocated for all scans of this handle */
+  if (scanner->ring.base == NULL
+      && ring_create (&scanner->ring, DCM300_RING) < 0)
+    {
+      DBG (MSG_ERR, "sane_open: no memory for ring buffer\n");
+      return SANE_STATUS_NO_MEM;
+    }
+  if (scanner->event_fd < 0)
+    scanner->event_fd = eventfd (0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (scanner->event_fd < 0)
+    {
+      DBG (MSG_ERR, "sane_open: eventfd: %s\n", strerror (errno));
+      return SANE_STATUS_IO_ERROR;
+    }
+
   *handle = scanner;
 
   init_options (scanner);
 
-  scanner->resolution = 1;
+  scanner->resolution = 1024;
   scanner->exposure = 200;
   scanner->gain_red = 31;
   scanner->gain_green = 25;
   scanner->gain_blue = 40;
   scanner->request_pixel.left = 0;
   scanner->request_pixel.top = 0;
-  scanner->request_pixel.right = 1023;
-  scanner->request_pixel.bottom = 767;
+  scanner->request_pixel.right = DCM300_WIDTH - 1;
+  scanner->request_pixel.bottom = DCM300_HEIGHT - 1;
   scanner->mode = 0;
+  scanner->non_blocking = 0;
   DBG (10, "resoluton=%d,left=%d top=%d right=%d bottom=%d\n", 
     scanner->resolution, 
     scanner->request_pixel.left, scanner->request_pixel.top, 
@@ -380,26 +449,31 @@ sane_open (SANE_String_Const name, SANE_Handle * handle)
 
 
 /**
- * An advanced method we don't support but have to define.
+ * In non-blocking mode sane_read() returns at once with
+ * zero bytes when the reader has nothing new.
  */
 SANE_Status
 sane_set_io_mode (SANE_Handle h, SANE_Bool non_blocking)
 {
+  struct dcm300_data *scanner = (struct dcm300_data *) h;
+
   DBG (10, "sane_set_io_mode\n");
   DBG (99, "%d %p\n", non_blocking, h);
-  return SANE_STATUS_UNSUPPORTED;
+  scanner->non_blocking = non_blocking;
+  return SANE_STATUS_GOOD;
 }
 
 
 /**
- * An advanced method we don't support but have to define.
+ * The eventfd is readable while sane_read() has data to
+ * return or the scan has ended.
  */
 SANE_Status
 sane_get_select_fd (SANE_Handle h, SANE_Int * fdp)
 {
   struct dcm300_data *scanner = (struct dcm300_data *) h;
   DBG (10, "sane_get_select_fd\n");
-  *fdp = scanner->pipe_r;
+  *fdp = scanner->event_fd;
   DBG (99, "%p %d\n", h, *fdp);
   return SANE_STATUS_GOOD;
 }
@@ -498,11 +572,10 @@ sane_control_option (SANE_Handle handle, SANE_Int option,
 	  *(SANE_Word *) val = NUM_OPTIONS;
 	  return SANE_STATUS_GOOD;
 
-#if 0
 	case OPT_RESOLUTION:
 	  *(SANE_Word *) val = scanner->resolution;
 	  return SANE_STATUS_GOOD;
-#endif
+
 	case OPT_EXPOSURE:
 	  *(SANE_Word *) val = scanner->exposure;
 	  return SANE_STATUS_GOOD;
@@ -573,7 +646,6 @@ sane_control_option (SANE_Handle handle, SANE_Int option,
        */
       switch (option)
 	{
-#if 0
 	case OPT_RESOLUTION:
 	  if (scanner->resolution == *(SANE_Word *) val)
 	    {
@@ -583,7 +655,7 @@ sane_control_option (SANE_Handle handle, SANE_Int option,
 	  calculateDerivedValues (scanner);
 	  *info |= SANE_INFO_RELOAD_PARAMS;
 	  return SANE_STATUS_GOOD;
-#endif
+
 	case OPT_EXPOSURE:
 	  if (scanner->exposure == *(SANE_Word *) val)
 	    {
@@ -682,7 +754,6 @@ SANE_Status
 sane_start (SANE_Handle handle)
 {
   struct dcm300_data *scanner = handle;
-  int defaultFds[2];
   int ret;
 
   DBG (10, "sane_start\n");
@@ -699,6 +770,22 @@ sane_start (SANE_Handle handle)
 	  return SANE_STATUS_INVAL;
 	}
     }
+  if (scanner->session == NULL)
+    {
+      struct dcm300_transport usb =
+	{ dcm300_usb_write, dcm300_usb_read, scanner, NULL };
+
+      /* default bulk and ring, no hooks, serial */
+      scanner->session = dcm300_session_create (&usb, NULL, NULL);
+      if (scanner->session == NULL)
+	return SANE_STATUS_NO_MEM;
+    }
+
+  /* previous scan not read to the end, its reader must be
+   * gone before the geometry of the new scan is set
+   */
+  if (scanner->reader_running)
+    do_cancel (scanner);
 
   calculateDerivedValues (scanner);
 
@@ -706,34 +793,22 @@ sane_start (SANE_Handle handle)
   DBG (10, "\tpixels_per_line = %d\n", scanner->scan_width_pixels);
   DBG (10, "\tlines = %d\n", scanner->scan_height_pixels);
 
-
-  /* create a pipe, fds[0]=read-fd, fds[1]=write-fd */
-  if (pipe (defaultFds) < 0)
-    {
-      DBG (MSG_ERR, "ERROR: could not create pipe\n");
-      do_cancel (scanner);
-      return SANE_STATUS_IO_ERROR;
-    }
-
-  scanner->pipe_r = defaultFds[0];
-  scanner->pipe_w = defaultFds[1];
+  atomic_store (&scanner->ring_head, 0);
+  atomic_store (&scanner->ring_tail, 0);
+  atomic_store (&scanner->reader_done, 0);
+  atomic_store (&scanner->cancel, 0);
+  scanner->reader_status = SANE_STATUS_GOOD;
+  dcm300_event_clear (scanner);
 
   ret = SANE_STATUS_GOOD;
 
-  scanner->reader_pid = sanei_thread_begin (reader_process, scanner);
-  time (&scanner->last_scan);
-
-  if (scanner->reader_pid == -1)
+  if (pthread_create (&scanner->reader, NULL, reader_thread, scanner))
     {
-      DBG (MSG_ERR, "cannot fork reader process.\n");
-      DBG (MSG_ERR, "%s", strerror (errno));
+      DBG (MSG_ERR, "cannot start reader thread.\n");
       ret = SANE_STATUS_IO_ERROR;
     }
-
-  if (sanei_thread_is_forked ())
-    {
-      close (scanner->pipe_w);
-    }
+  else
+    scanner->reader_running = 1;
 
   if (ret == SANE_STATUS_GOOD)
     {
@@ -793,10 +868,10 @@ sane_get_parameters (SANE_Handle handle, SANE_Parameters * params)
 /**
  * Called by SANE to read data.
  * 
- * In this implementation, sane_read does nothing much besides reading
- * data from a pipe and handing it back. On the other end of the pipe
- * there's the reader process which gets data from the scanner and
- * stuffs it into the pipe.
+ * In this implementation, sane_read does nothing much besides copying
+ * data out of the ring buffer. On the other end of the ring there's
+ * the reader thread which gets data from the scanner and stuffs it
+ * into the ring.
  * 
  * From the SANE spec:
  * This function is used to read image data from the device
@@ -814,38 +889,61 @@ sane_read (SANE_Handle handle, SANE_Byte * buf,
 	   SANE_Int max_len, SANE_Int * len)
 {
   struct dcm300_data *scanner = (struct dcm300_data *) handle;
-  ssize_t nread;
-  int source = scanner->pipe_r;
+  struct pollfd pfd;
+  unsigned int head, tail;
+  int done, n;
 
   *len = 0;
 
-  nread = read (source, buf, max_len);
-  DBG (30, "sane_read: read %ld bytes of %ld\n",
-       (long) nread, (long) max_len);
-
-  if (nread < 0)
+  for (;;)
     {
-      if (errno == EAGAIN)
+      /* clear first, the reader signals again for anything later */
+      dcm300_event_clear (scanner);
+      done = atomic_load_explicit (&scanner->reader_done, memory_order_acquire);
+      head = atomic_load_explicit (&scanner->ring_head, memory_order_acquire);
+      tail = atomic_load_explicit (&scanner->ring_tail, memory_order_relaxed);
+
+      if (head != tail)
 	{
+	  n = head - tail;
+	  if (n > max_len)
+	    n = max_len;
+	  memcpy (buf, ring_at (&scanner->ring, tail), n);
+	  atomic_store_explicit (&scanner->ring_tail, tail + n,
+				 memory_order_release);
+	  *len = n;
+	  /* keep the select fd readable for the rest */
+	  if (head != tail + n || done)
+	    dcm300_event_signal (scanner);
+	  DBG (30, "sane_read: read %d bytes of %ld\n", n, (long) max_len);
 	  return SANE_STATUS_GOOD;
 	}
-      else
+
+      if (done)
 	{
-	  do_cancel (scanner);
-	  return SANE_STATUS_IO_ERROR;
+	  if (scanner->reader_running)
+	    {
+	      pthread_join (scanner->reader, NULL);
+	      scanner->reader_running = 0;
+	    }
+	  DBG (10, "sane_read: scan complete\n");
+	  /* keep the select fd readable, the next call ends too */
+	  dcm300_event_signal (scanner);
+	  return scanner->reader_status == SANE_STATUS_GOOD ?
+	    SANE_STATUS_EOF : scanner->reader_status;
 	}
-    }
 
-  *len = nread;
+      if (scanner->non_blocking)
+	return SANE_STATUS_GOOD;
 
-  if (nread == 0)
-    {
-      close (source);
-      DBG (10, "sane_read: pipe closed\n");
-      return SANE_STATUS_EOF;
+      pfd.fd = scanner->event_fd;
+      pfd.events = POLLIN;
+      if (poll (&pfd, 1, -1) < 0 && errno != EINTR)
+	{
+	  do_cancel (scanner);
+	  return SANE_STATUS_IO_ERROR;
+	}
     }
-
-  return SANE_STATUS_GOOD;
 }				/* sane_read */
 
 
@@ -909,6 +1007,7 @@ sane_close (SANE_Handle handle)
   DBG (10, "sane_close\n");
   do_reset (handle);
   do_cancel (handle);
+  do_release (handle);
 }
 
 
@@ -936,12 +1035,20 @@ sane_exit (void)
   for (dev = first_dev; dev; dev = next)
     {
       next = dev->next;
+      do_cancel (dev);
+      do_release (dev);
+      dcm300_session_destroy (dev->session);
       free (dev->devicename);
       free (dev);
     }
 
+  first_dev = 0;
+  new_dev = &first_dev;
+  num_devices = 0;
+
   if (devlist)
     free (devlist);
+  devlist = 0;
 }
 
 /*
@@ -952,6 +1059,8 @@ static SANE_Status
 attachScanner (const char *devicename)
 {
   struct dcm300_data *dev;
+  char spec[16];
+  int bus, devnum;
 
   DBG (15, "attach_scanner: %s\n", devicename);
 
@@ -971,17 +1080,28 @@ attachScanner (const char *devicename)
 
   dev->devicename = strdup (devicename);
   dev->sfd = -1;
-  dev->last_scan = 0;
-  dev->reader_pid = 0;
-  dev->pipe_r = dev->pipe_w = -1;
+  dev->event_fd = -1;
 
   dev->sane.name = dev->devicename;
   dev->sane.vendor = "ScopeTek";
   dev->sane.model = "DCM300";
   dev->sane.type = "still camera";
 
+  /* several cameras are told apart by the port they are
+     plugged into, the device number changes on replug */
+  if (sscanf (devicename, "libusb:%d:%d", &bus, &devnum) == 2)
+    {
+      snprintf (spec, sizeof (spec), "%03d:%03d", bus, devnum);
+      if (dcm300_camera_find (&dev->camera, spec) == 0)
+	{
+	  snprintf (dev->model, sizeof (dev->model), "DCM300 %s", dev->camera.id);
+	  dev->sane.model = dev->model;
+	}
+    }
+
   ++num_devices;
   *new_dev = dev;
+  new_dev = &dev->next;
 
   DBG (15, "attach_scanner: done\n");
 
@@ -1007,17 +1127,18 @@ init_options (struct dcm300_data *scanner)
   opt->title = SANE_TITLE_NUM_OPTIONS;
   opt->desc = SANE_DESC_NUM_OPTIONS;
   opt->cap = SANE_CAP_SOFT_DETECT;
-#if 0
+
   opt = scanner->opt + OPT_RESOLUTION;
   opt->name = SANE_NAME_SCAN_RESOLUTION;
   opt->title = SANE_TITLE_SCAN_RESOLUTION;
-  opt->desc = SANE_DESC_SCAN_RESOLUTION;
+  opt->desc = SANE_I18N ("Pixels across the full sensor width: "
+			 "2048 full resolution, 1024, 512 or 256 binned");
   opt->type = SANE_TYPE_INT;
   opt->constraint_type = SANE_CONSTRAINT_WORD_LIST;
   opt->constraint.word_list = res_list;
   opt->unit = SANE_UNIT_PIXEL;
   opt->cap = SANE_CAP_SOFT_SELECT | SANE_CAP_SOFT_DETECT;
-#endif
+
   opt = scanner->opt + OPT_EXPOSURE;
   opt->name = SANE_NAME_BRIGHTNESS;
   opt->title = SANE_I18N ("Exposure");
@@ -1143,41 +1264,67 @@ do_reset (struct dcm300_data *scanner)
 static void
 do_cancel (struct dcm300_data *scanner)
 {
-  if (scanner->reader_pid > 0)
+  if (scanner->reader_running)
     {
-
-      if (sanei_thread_kill (scanner->reader_pid) == 0)
-	{
-	  int exit_status;
-
-	  sanei_thread_waitpid (scanner->reader_pid, &exit_status);
-	}
-      scanner->reader_pid = 0;
+      atomic_store (&scanner->cancel, 1);
+      pthread_join (scanner->reader, NULL);
+      scanner->reader_running = 0;
     }
-  if (scanner->pipe_r >= 0)
+}
+
+/* ring buffer and select fd live from sane_open() to sane_close() */
+static void
+do_release (struct dcm300_data *scanner)
+{
+  ring_destroy (&scanner->ring);
+  if (scanner->event_fd >= 0)
     {
-      close (scanner->pipe_r);
-      scanner->pipe_r = -1;
+      close (scanner->event_fd);
+      scanner->event_fd = -1;
     }
 }
 
 static void
 calculateDerivedValues (struct dcm300_data *scanner)
 {
+  int x, y, w, h;
 
   DBG (12, "calculateDerivedValues\n");
 
-  /* Convert the SANE_FIXED values for the scan area into 1/1200 inch 
-   * scanner units */
-
   DBG (12, "\tleft margin: %u\n", scanner->request_pixel.left);
   DBG (12, "\ttop margin: %u\n", scanner->request_pixel.top);
   DBG (12, "\tright margin: %u\n", scanner->request_pixel.right);
   DBG (12, "\tbottom margin: %u\n", scanner->request_pixel.bottom);
 
-  /* add +1 because we include first and last pixel 0-1023, 0-767 */
-  scanner->scan_width_pixels = scanner->request_pixel.right - scanner->request_pixel.left + 1;
-  scanner->scan_height_pixels = scanner->request_pixel.bottom - scanner->request_pixel.top + 1;
+  scanner->bin = DCM300_WIDTH / scanner->resolution;
+
+  /* the camera crops: TL/BR rounded out to even offsets and
+   * the width and height steps it accepts. Those steps are
+   * multiples of every bin factor. add +1 because we include
+   * first and last pixel
+   */
+  x = scanner->request_pixel.left & ~1;
+  y = scanner->request_pixel.top & ~1;
+  w = scanner->request_pixel.right + 1 - x;
+  h = scanner->request_pixel.bottom + 1 - y;
+  if (w < 1)
+    w = 1;
+  if (h < 1)
+    h = 1;
+  w = (w + DCM300_ALIGN_X - 1) / DCM300_ALIGN_X * DCM300_ALIGN_X;
+  h = (h + DCM300_ALIGN_Y - 1) / DCM300_ALIGN_Y * DCM300_ALIGN_Y;
+  if (x + w > DCM300_WIDTH)
+    x = DCM300_WIDTH - w;
+  if (y + h > DCM300_HEIGHT)
+    y = DCM300_HEIGHT - h;
+  scanner->sensor.left = x;
+  scanner->sensor.top = y;
+  scanner->sensor.right = x + w;
+  scanner->sensor.bottom = y + h;
+  DBG (12, "\tsensor window: %dx%d+%d+%d bin %d\n", w, h, x, y, scanner->bin);
+
+  scanner->scan_width_pixels = w / scanner->bin;
+  scanner->scan_height_pixels = h / scanner->bin;
 
   scanner->bytes_per_scan_line = scanner->scan_width_pixels * 3;
 
@@ -1186,10 +1333,6 @@ calculateDerivedValues (struct dcm300_data *scanner)
 
 /* From here on in we have the original code written for the scanner demo */
 
-static int udh;
-static int cancelled_scan = 0;
-static int do_warmup = 1;
-
 int printhex(char *tag, unsigned char *a, int n)
 {
   int i, pos = 0;
@@ -1237,366 +1380,87 @@ dcm300_scan_test  (unsigned x,
   return 0;
 }
 
-/* image get packet for dcm300
-*/
-struct dcm300_request {
-  unsigned char unknown1a;      /* 2c */
-  unsigned char unknown1a_0[1]; /* 00 */
-  unsigned char unknown1b;      /* 0e */
-  unsigned char unknown1b_0[1]; /* 00 */
-  unsigned char unknown1c;      /* 01 */
-  unsigned char unknown1_0[7];  /* 00 ... */
-  unsigned char unknown2;       /* 20 */
-  unsigned char unknown2_0[1];  /* 00 ... */
-  unsigned char unknown3a;      /* maybe gamma maybe not, values seen: bf,d6,da,b0,e1 */
-  unsigned char unknown3;       /* 05 */
-  unsigned char resolution_y_lo, resolution_y_hi;
-  unsigned char unknown3_0[2];  /* 00 ... */
-  unsigned char resolution_x_lo, resolution_x_hi;
-  unsigned char unknown4_0[2];  /* 00 ... */
-  unsigned char offset_x_lo, offset_x_hi;
-  unsigned char offset_x_hlo, offset_x_hhi;
-  // unsigned char unknown5_0[2];  /* 00 ... */
-  unsigned char offset_y_lo, offset_y_hi;
-  unsigned char unknown6_0[2];  /* 00 ... */
-  unsigned char exposure_lo, exposure_hi; /* lo,hi = exp + 20 */
-  unsigned char unknown7_0[2];  /* 00 ... */
-  unsigned char gain_red, gain_green, gain_blue;
-  unsigned char unknown8_0[1];
-  unsigned char unknown9;       /* 02 */
-  unsigned char unknown9_0[23]; /* 00 ... */
-};
-
-/* parameters for taking a snapshot with dcm300
-*/
-struct dcm300_snapshot {
-  unsigned int resolution_x, resolution_y;
-  unsigned int offset_x, offset_y;
-  unsigned int exposure;
-  unsigned char gain_red, gain_green, gain_blue;
-};
-
-int dcm300_create_request(struct dcm300_snapshot *s, struct dcm300_request *r)
+/* sanei_usb bulk transfers for the capture library */
+static int
+dcm300_usb_write (void *ctx, u8 *data, int len)
 {
-  memset(r, 0, sizeof(*r));
+  struct dcm300_data *scanner = ctx;
+  size_t n = len;
 
-  r->unknown1a = 0x2c;
-  r->unknown1b = 0x0e;
-  r->unknown1c = 0x01;
-
-  r->unknown2 = 0x20;
-  r->unknown3a = 0xbf;
-  r->unknown3 = 0x05;
-  r->unknown9 = 0x02;
-  
-  r->resolution_x_lo = (s->resolution_x) % 256;
-  r->resolution_x_hi = (s->resolution_x) / 256;
-  r->resolution_y_lo = (s->resolution_y) % 256;
-  r->resolution_y_hi = (s->resolution_y) / 256;
-
-  r->offset_x_lo = (s->offset_x) % 256;
-  r->offset_x_hi = (s->offset_x) / 256;
-
-  r->offset_y_lo = (s->offset_y) % 256;
-  r->offset_y_hi = (s->offset_y) / 256;
-
-  r->exposure_lo = (s->exposure + 20) % 256;
-  r->exposure_hi = (s->exposure + 20) / 256;
-
-  r->gain_red   = s->gain_red;
-  r->gain_green = s->gain_green;
-  r->gain_blue  = s->gain_blue;
-
-
-  return 0;
-}
-
-#define BAYER_CIRCULAR 32768
-
-/* returns last bayer_start that was left unprocessed */
-int bayer_circular_downscale(
-              unsigned char *bayer_array, 
-              int bayer_width, /* number of columns in a row of the bayer array */
-              int *bayer_start, /* modified to the next start */
-              int bayer_stop, /* end of read bytes */
-              unsigned char *rgb_array,
-              int *rgb_len)
-{
-  int  i, j, irgb;
-  int bayer_last;
-  
-  /* even number of complete bayer lines */  
-  bayer_last = *bayer_start + (bayer_stop - *bayer_start) - ((bayer_stop - *bayer_start) % (2*bayer_width));
-  DBG(30, "bayer: start %08x stop %08x last %08x\n", *bayer_start, bayer_stop, bayer_last);
-  irgb = 0;
-  for(i = *bayer_start; i < bayer_last; i += 2*bayer_width )
-  {
-    for(j = i; j < i + bayer_width; j += 2)
-    {
-      rgb_array[irgb++] = bayer_array[ (j) % BAYER_CIRCULAR];
-      rgb_array[irgb++] = (bayer_array[ (j + 1) % BAYER_CIRCULAR] + bayer_array[ (j + bayer_width) % BAYER_CIRCULAR ])/2;
-      rgb_array[irgb++] = bayer_array[ (j + bayer_width + 1) % BAYER_CIRCULAR];
-      if(irgb > 3*8192)
-      {
-        DBG(1, "cat't fit to rgb - need bayer force exit\n");
-        goto force_exit;
-      }
-    }
-  }
-  
-  force_exit:;
-  
-  *bayer_start = i;
-  *rgb_len = irgb;
-  return i;
+  if (sanei_usb_write_bulk (scanner->sfd, data, &n) != SANE_STATUS_GOOD)
+    return -1;
+  return n;
 }
-              
 
 static int
-dcm300_scan  (unsigned x1,
-	      unsigned y1,
-	      unsigned w1,
-	      unsigned h1,
-	      unsigned exposure,
-	      unsigned gain_red,
-	      unsigned gain_green,
-	      unsigned gain_blue, 
-	      dcm300_callback cbfunc, void *param)
+dcm300_usb_read (void *ctx, u8 *data, int len)
 {
-  unsigned int i, j;
-  int image_len;
-  size_t request_len; /* bytes in reply image and request */
-  struct dcm300_request r[1];
-  struct dcm300_snapshot s[1];
-  SANE_Status result;
-  int bulk_header_len = 64; /* first bulk packet after request */
-  int bulk_content_len = 16384; /* bulk reply chunk size */
-  int bulk_footer_len = 256;  /* trailing bytes. Not necessary size of the last bulk */
-                                 /* due to anomaly e.g. at 800x600 , last bulk may be e.g. 512 bytes, 
-                                 ** merged 2 things in athe last bulk:
-                                 ** 1. last 256 bytes of the image and
-                                 ** 2. the trailing 256 bytes */
-  int bytes_read = 0; /* bytes of the image read */
-  size_t bulk_len; /* temporary value of bulk number of bytes read */
-  int bulk_want;
-  int bayer_from = 0;
-  unsigned char replybuf[BAYER_CIRCULAR];
-  unsigned char rgb[3*BAYER_CIRCULAR/2];
-  /* speed issue - need to buffer image before writing */
-  unsigned char rgbimage[3*1024*768];
-  int rgb_len, rgb_left, rgb_num, rgb_done;
-  int x = 0, y = 0, w = 1024, h = 768; /* always use this resolution */
-
-
-  /*
-  ** as we will do the simple demosaic rggb->rgb 
-  ** resolution will actually be half of other bayer
-  ** demosaicing methods
-  **
-  ** Many sophisticated bayer demosaicings exist. they produce
-  ** 3-byte RGB value from each single byte in bayer array,
-  ** but IMHO they can't
-  ** add much more information to the image but they 
-  ** can add blur and may have artefacts
-  **
-  ** bayer array is RGGB 2048x1536 and this code will
-  ** transform it on-the-fly into RGB 1024x768
-  **
-  **      G=(G1+G2)/2 (mean green)
-  **
-  ** R G R G
-  ** G B G B  -->  RGB RGB
-  ** R G R G  -->  RGB RGB
-  ** G B G B
-  */
-  
-  s->resolution_x = 0xfff0 & (2*w); 
-  s->resolution_y = 0xfff0 & (2*h);
-  s->offset_x     = 2*x;
-  s->offset_y     = 2*y;
-  s->exposure     = exposure;
-  s->gain_red     = gain_red;
-  s->gain_green   = gain_green;
-  s->gain_blue    = gain_blue;
-  
-  /* read data and demosaic them on-the fly.
-  ** each bulk read is 16K long. Use 32K circular buffer
-  ** to place alternating reads. Track the position
-  ** using 32K modulo and process data as if they 
-  ** were linear
-  */
-  
-  /* due to a bug or something we don't know,
-  ** image has to be acquired twice otherwise
-  ** usb protocol blocks at the next attempt to scan
-  */
-  for(j = 0; j < 2; j++)
-  {
-#if 1
-
-    /* make request */
-    dcm300_create_request(s, r);
-
-    request_len = sizeof(r);
-    image_len = s->resolution_x * s->resolution_y;
-    DBG(10, "request created (%d bytes). expecting 64+0x%08X+256 bytes\n", (int) request_len, image_len);
-    printhex("request:", (unsigned char *)r, request_len);
-
-    result = sanei_usb_write_bulk (udh, (unsigned char *)r, &request_len);
-
-    if (result != SANE_STATUS_GOOD)
-    {
-      DBG(1, "request write failed\n");
-      goto exitscan;
-    }
-
-    bulk_len = bulk_header_len;
-    result = sanei_usb_read_bulk (udh, replybuf, &bulk_len);
-    if (result != SANE_STATUS_GOOD)
-    {
-      DBG(1, "header bulk read error\n");
-      goto exitscan;
-    }
-    DBG(20, "header bulk want=%d got=%d\n", bulk_header_len, (int)bulk_len);
-    bayer_from = 0;
-    rgb_left = 3*w*h;
-    rgb_done = 0;
-    bulk_want = bulk_len = 0;
-    for(bytes_read = 0; bytes_read < image_len && bulk_want == (int)bulk_len; bytes_read += bulk_len)
-    {
-      bulk_want = image_len - bytes_read > bulk_content_len ? bulk_content_len : image_len - bytes_read;
-      bulk_len = (bytes_read % BAYER_CIRCULAR) + bulk_want <= BAYER_CIRCULAR ?  bulk_want : BAYER_CIRCULAR - (bytes_read % BAYER_CIRCULAR);
-      result = sanei_usb_read_bulk (udh, replybuf + (bytes_read % BAYER_CIRCULAR), &bulk_len);
-      if (result != SANE_STATUS_GOOD)
-      {
-        DBG(1, "content bulk read error\n");
-        goto exitscan1;
-      }
-      bayer_circular_downscale(replybuf, s->resolution_x, &bayer_from, bytes_read + bulk_len, rgb, &rgb_len);
-      rgb_num = 0;
-      if(j == 1 && rgb_left > 0)
-      {
-        rgb_num = rgb_left > rgb_len ? rgb_len : rgb_left;
-        memcpy(rgbimage + rgb_done, rgb, rgb_num);
-        rgb_done += rgb_num;
-        rgb_left -= rgb_num;
-      }
-      DBG(20, "content bulk at %08X want:%d got:%d rgb:%d\n", bytes_read, bulk_want, (int)bulk_len, rgb_num);
-    }
-    exitscan1:;
-    DBG(20, "content bulks complete\n");
-    bulk_want = image_len - bytes_read + bulk_footer_len> bulk_content_len ? bulk_content_len : image_len - bytes_read + bulk_footer_len;
-    bulk_len = (bytes_read % BAYER_CIRCULAR) + bulk_want <= BAYER_CIRCULAR ?  bulk_want : BAYER_CIRCULAR - (bytes_read % BAYER_CIRCULAR);
-    result = sanei_usb_read_bulk (udh, replybuf + (bytes_read % BAYER_CIRCULAR), &bulk_len);
-    if (result != SANE_STATUS_GOOD)
-    {
-      DBG(1, "footer bulk read error\n");
-      goto exitscan;
-    }
-    bayer_circular_downscale(replybuf, s->resolution_x, &bayer_from, bytes_read + bulk_len, rgb, &rgb_len);     
-    rgb_num = 0;
-    if(j == 1 && rgb_left > 0)
-    {
-      rgb_num = rgb_left > rgb_len ? rgb_len : rgb_left;
-      memcpy(rgbimage + rgb_done, rgb, rgb_num);
-      rgb_done += rgb_num;
-      rgb_left -= rgb_num;
-    }
-    DBG(20, "footer bulk at %08X want:%d got:%d rgb:%d\n", bytes_read, bulk_want, (int)bulk_len, rgb_num);
-    if(rgb_done == 3*w*h)
-    {
-      DBG(10, "write %08X bytes image\n", rgb_done);
-      /* (*cbfunc)(param, rgb_done, rgbimage); */
-      for(i = 0; i < h1; i++)
-        (*cbfunc)(param, 3*w1, rgbimage + 3*(w*(i + y1) + x1) );
-    }
-    else
-    {
-      DBG(1, "image size mismatch: want:%08x got:%08x\n", 3*w*h, rgb_done);
-    }
-#endif
-  
-  }
-  exitscan:;
+  struct dcm300_data *scanner = ctx;
+  size_t n = len;
 
-  return 0;
+  if (sanei_usb_read_bulk (scanner->sfd, data, &n) != SANE_STATUS_GOOD)
+    return -1;
+  return n;
 }
 
-
+/* copy rows into the ring. It holds a whole frame and is
+** emptied at sane_start(), waiting for sane_read() is only
+** a safety net. returns -1 when cancelled
+*/
 static int
-writefunc (struct dcm300_write_info *winfo, int bytes, char *data)
+writefunc (struct dcm300_write_info *winfo, unsigned bytes, char *data)
 {
+  struct dcm300_data *scanner = winfo->scanner;
+  struct timespec t = { 0, DCM300_POLL_NS };
+  unsigned int head, used, n;
   static int warned = 0;
 
-  if (bytes > winfo->bytesleft)
+  if (bytes > (unsigned) winfo->bytesleft)
     {
       if (!warned)
 	{
 	  warned = 1;
 	  DBG (1, "Overflow protection triggered\n");
-#if 0
-	  rt_stop_moving ();
-#endif
 	}
       bytes = winfo->bytesleft;
       if (!bytes)
-	return 0;
+	return -1;
     }
   winfo->bytesleft -= bytes;
-  return write (winfo->scanner->pipe_w, data, bytes) == bytes;
-}
 
-static void
-sigtermHandler (int signal)
-{
-  signal = signal;		/* get rid of compiler warning */
-  cancelled_scan = 1;
+  head = atomic_load_explicit (&scanner->ring_head, memory_order_relaxed);
+  while (bytes > 0)
+    {
+      if (atomic_load_explicit (&scanner->cancel, memory_order_relaxed))
+	return -1;
+      used = head - atomic_load_explicit (&scanner->ring_tail,
+					  memory_order_acquire);
+      if (used == (unsigned int) scanner->ring.size)
+	{
+	  nanosleep (&t, NULL);
+	  continue;
+	}
+      n = scanner->ring.size - used;
+      if (n > bytes)
+	n = bytes;
+      memcpy (ring_at (&scanner->ring, head), data, n);
+      head += n;
+      atomic_store_explicit (&scanner->ring_head, head, memory_order_release);
+      dcm300_event_signal (scanner);
+      data += n;
+      bytes -= n;
+    }
+  return 0;
 }
 
-static int
-reader_process (void *pv)
+static void *
+reader_thread (void *pv)
 {
   struct dcm300_data *scanner = pv;
-  time_t t;
-  sigset_t ignore_set;
-  sigset_t sigterm_set;
-  struct SIGACTION act;
   struct dcm300_write_info winfo;
-
-  if (sanei_thread_is_forked ())
-    {
-      close (scanner->pipe_r);
-    }
-
-  sigfillset (&ignore_set);
-  sigdelset (&ignore_set, SIGTERM);
-#if defined (__APPLE__) && defined (__MACH__)
-  sigdelset (&ignore_set, SIGUSR2);
-#endif
-  sigprocmask (SIG_SETMASK, &ignore_set, 0);
-
-  sigemptyset (&sigterm_set);
-  sigaddset (&sigterm_set, SIGTERM);
-
-  memset (&act, 0, sizeof (act));
-#ifdef _POSIX_SOURCE
-  act.sa_handler = sigtermHandler;
-#endif
-  sigaction (SIGTERM, &act, 0);
-
-
-  /* Warm up the lamp again if our last scan ended more than 5 minutes ago. */
-  time (&t);
-  do_warmup = (t - scanner->last_scan) > 300;
-
-#if 0
-  if (getenv ("HP3500_NOWARMUP") && atoi (getenv ("HP3500_NOWARMUP")) > 0)
-    do_warmup = 0;
-#endif
-
-  udh = scanner->sfd;
-
-  cancelled_scan = 0;
+  struct dcm300_snapshot snapshot;
+  long threads;
+  SANE_Status status;
 
   winfo.scanner = scanner;
   winfo.bytesleft =
@@ -1605,15 +1469,29 @@ reader_process (void *pv)
   DBG (10, "Scanning at %ddpi, mode=%s\n", scanner->resolution,
        scan_mode_list[scanner->mode]);
 
-  if (dcm300_scan
-      (scanner->request_pixel.left,
-       scanner->request_pixel.top,
-       scanner->scan_width_pixels,
-       scanner->scan_height_pixels,
-       scanner->exposure, 
-       scanner->gain_red, scanner->gain_green, scanner->gain_blue, 
-       (dcm300_callback) writefunc,
-       &winfo) >= 0)
-    exit (SANE_STATUS_GOOD);
-  exit (SANE_STATUS_IO_ERROR);
+  memset (&snapshot, 0, sizeof (snapshot));
+  snapshot.x = scanner->sensor.left;
+  snapshot.y = scanner->sensor.top;
+  snapshot.w = scanner->sensor.right - scanner->sensor.left;
+  snapshot.h = scanner->sensor.bottom - scanner->sensor.top;
+  snapshot.exposure = scanner->exposure;
+  snapshot.red = scanner->gain_red;
+  snapshot.green = scanner->gain_green;
+  snapshot.blue = scanner->gain_blue;
+  snapshot.bin = scanner->bin;
+  snapshot.method = DEMOSAIC_MHC;
+  threads = sysconf (_SC_NPROCESSORS_ONLN);
+  snapshot.threads = threads > 0 ? threads : 1;
+
+  /* the session warms up the camera unless its previous scan completed */
+  status = dcm300_session_capture (scanner->session, &snapshot,
+				   (dcm300_rows_callback) writefunc, &winfo)
+    == 0 ? SANE_STATUS_GOOD : SANE_STATUS_IO_ERROR;
+  if (atomic_load (&scanner->cancel))
+    status = SANE_STATUS_CANCELLED;
+
+  scanner->reader_status = status;
+  atomic_store_explicit (&scanner->reader_done, 1, memory_order_release);
+  dcm300_event_signal (scanner);
+  return NULL;
 }
@@ -0,0 +1,48 @@
+#ifndef SESSION_H
+#define SESSION_H
+#include "libdcm300.h"
+#include "demosaic.h"
+#include "ring.h"
+
+/* capture session, private to the library.
+** dcm300_session_process() is the one path of every
+** transfer, serial on the reading thread or pipelined
+** on the conversion thread
+*/
+
+#define DCM300_HEADER 64 /* first bulk packet after request */
+#define DCM300_FOOTER 256 /* trailing bytes, due to anomaly e.g. at 800x600 the
+                          ** last bulk may merge the last 256 bytes of the image
+                          ** with them */
+
+struct pipeline;
+
+struct dcm300_session {
+  struct dcm300_transport t;
+  struct dcm300_config config; /* defaults filled in, ring as allocated */
+  struct dcm300_hooks hooks;
+  int warm; /* 1-last frame completed, camera answers the next request */
+  u64 warm_ns; /* when the last frame completed */
+  int pinned; /* 1-buffers are locked in memory */
+  struct ring bayer; /* the stream at its positions, mirrored */
+  u8 *rgb; /* binned rows of one transfer */
+  struct pipeline *pipeline; /* conversion and writer threads or NULL */
+  /* current capture */
+  const struct dcm300_snapshot *s;
+  dcm300_rows_callback cbfunc;
+  void *param;
+  struct demosaic *d; /* full resolution demosaic or NULL */
+  int warming; /* 1-warm-up frame, only metered */
+  int stacking; /* 1-frames go to the stack_add hook */
+  int pipelined; /* 1-threads of the current frame are running */
+  int bayer_read; /* stream position of the next byte to read */
+  int bayer_from; /* stream position of the next unconverted row */
+  int bayer_end; /* end of the image */
+  int error; /* 1-row callback stopped the capture */
+  u64 deliver_ns; /* running time in the row callback, out of conversion time */
+};
+
+void dcm300_session_process(struct dcm300_session *session, int len);
+int dcm300_session_needed(struct dcm300_session *session);
+
+#endif
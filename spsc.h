@@ -0,0 +1,81 @@
+#ifndef SPSC_H
+#define SPSC_H
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* lock-free single producer single consumer queue
+** of fixed size elements. head is written only by the
+** producer and tail only by the consumer, each on its
+** own cache line. Neither side ever blocks, push fails
+** when the queue is full and pop when it is empty.
+*/
+
+#define SPSC_CACHELINE 64
+
+struct spsc {
+  _Alignas(SPSC_CACHELINE) atomic_uint head; /* next slot to push */
+  _Alignas(SPSC_CACHELINE) atomic_uint tail; /* next slot to pop */
+  _Alignas(SPSC_CACHELINE) unsigned int mask; /* slots - 1, slots is power of 2 */
+  int elem; /* bytes per element */
+  unsigned char *slot;
+};
+
+/* room for at least n elements */
+static inline int spsc_init(struct spsc *q, int n, int elem)
+{
+  unsigned int slots = 1;
+
+  while(slots < (unsigned int) n)
+    slots <<= 1;
+  atomic_init(&q->head, 0);
+  atomic_init(&q->tail, 0);
+  q->mask = slots - 1;
+  q->elem = elem;
+  q->slot = malloc(slots * elem);
+  return q->slot ? 0 : -1;
+}
+
+static inline void spsc_destroy(struct spsc *q)
+{
+  free(q->slot);
+  q->slot = NULL;
+}
+
+static inline unsigned int spsc_capacity(struct spsc *q)
+{
+  return q->mask + 1;
+}
+
+/* elements in the queue, exact for either side */
+static inline unsigned int spsc_count(struct spsc *q)
+{
+  return atomic_load_explicit(&q->head, memory_order_acquire)
+       - atomic_load_explicit(&q->tail, memory_order_acquire);
+}
+
+/* producer only. returns -1 if full */
+static inline int spsc_push(struct spsc *q, const void *e)
+{
+  unsigned int head = atomic_load_explicit(&q->head, memory_order_relaxed);
+
+  if(head - atomic_load_explicit(&q->tail, memory_order_acquire) > q->mask)
+    return -1;
+  memcpy(q->slot + (head & q->mask) * q->elem, e, q->elem);
+  atomic_store_explicit(&q->head, head + 1, memory_order_release);
+  return 0;
+}
+
+/* consumer only. returns -1 if empty */
+static inline int spsc_pop(struct spsc *q, void *e)
+{
+  unsigned int tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+
+  if(atomic_load_explicit(&q->head, memory_order_acquire) == tail)
+    return -1;
+  memcpy(e, q->slot + (tail & q->mask) * q->elem, q->elem);
+  atomic_store_explicit(&q->tail, tail + 1, memory_order_release);
+  return 0;
+}
+
+#endif
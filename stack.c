@@ -0,0 +1,120 @@
+/* stack.c
+**
+** Multi frame averaging and digital long exposure,
+** SSE2 or NEON widening add into 16 bit accumulator
+**
+** License: GPL
+**
+*/
+#include "stack.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
+int stack_mode(char *name)
+{
+  if(strcmp(name, "sum") == 0)
+    return STACK_SUM;
+  return STACK_MEAN;
+}
+
+struct stack *stack_create(int mode, int frames)
+{
+  struct stack *s;
+
+  s = calloc(1, sizeof(*s));
+  if(s == NULL)
+    return NULL;
+  s->mode = mode;
+  s->frames = frames < 1 ? 1 : frames > STACK_MAX_FRAMES ? STACK_MAX_FRAMES : frames;
+  return s;
+}
+
+void stack_destroy(struct stack *s)
+{
+  if(s == NULL)
+    return;
+  free(s->acc);
+  free(s);
+}
+
+/* start a new stack of frames of size bayer pixels,
+** accumulator is kept while the size doesn't change
+*/
+void stack_reset(struct stack *s, int size)
+{
+  if(s->size != size)
+  {
+    free(s->acc);
+    s->acc = malloc(size * sizeof(*s->acc));
+    s->size = s->acc ? size : 0;
+  }
+  if(s->acc)
+    memset(s->acc, 0, s->size * sizeof(*s->acc));
+  s->added = 0;
+}
+
+static void stack_add_bytes(u16 *acc, const u8 *data, int n)
+{
+  int i = 0;
+
+#if defined(__SSE2__)
+  const __m128i zero = _mm_setzero_si128();
+
+  for(; i + 16 <= n; i += 16)
+  {
+    __m128i v = _mm_loadu_si128((const __m128i *) (data + i));
+    __m128i *a = (__m128i *) (acc + i);
+    _mm_storeu_si128(a, _mm_add_epi16(_mm_loadu_si128(a), _mm_unpacklo_epi8(v, zero)));
+    _mm_storeu_si128(a + 1, _mm_add_epi16(_mm_loadu_si128(a + 1), _mm_unpackhi_epi8(v, zero)));
+  }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+  for(; i + 16 <= n; i += 16)
+  {
+    uint8x16_t v = vld1q_u8(data + i);
+    vst1q_u16(acc + i, vaddw_u8(vld1q_u16(acc + i), vget_low_u8(v)));
+    vst1q_u16(acc + i + 8, vaddw_u8(vld1q_u16(acc + i + 8), vget_high_u8(v)));
+  }
+#endif
+  for(; i < n; i++)
+    acc[i] += data[i];
+}
+
+/* data holds len bytes of the stream from image offset pos.
+** header (negative pos) and footer bytes are skipped
+*/
+void stack_add(struct stack *s, int pos, const u8 *data, int len)
+{
+  int from = pos < 0 ? 0 : pos, stop = pos + len;
+
+  if(stop > s->size)
+    stop = s->size;
+  if(stop > from)
+    stack_add_bytes(s->acc + from, data + (from - pos), stop - from);
+}
+
+/* len bytes of the stacked frame from image offset pos */
+void stack_result(struct stack *s, int pos, u8 *out, int len)
+{
+  /* exact (acc + n/2) / n for 16 bit acc as multiply and shift */
+  u64 m = ((1ULL << 32) + s->added - 1) / (s->added ? s->added : 1);
+  u32 v;
+  int i;
+
+  if(pos + len > s->size)
+    len = s->size - pos;
+  for(i = 0; i < len; i++)
+  {
+    v = s->acc[pos + i];
+    if(s->mode == STACK_SUM)
+      out[i] = v > 255 ? 255 : v;
+    else
+      out[i] = ((v + s->added / 2) * m) >> 32;
+  }
+}
@@ -0,0 +1,29 @@
+#ifndef STACK_H
+#define STACK_H
+#include "binarytype.h"
+
+/* frames of a stack are added up at bayer level into one
+** 16 bit accumulator frame, while their bulks stream in
+*/
+
+#define STACK_MEAN 0 /* noise reduction */
+#define STACK_SUM  1 /* digital long exposure, saturates at 255 */
+
+#define STACK_MAX_FRAMES 257 /* 257*255 still fits 16 bits */
+
+struct stack {
+  int mode; /* STACK_MEAN or STACK_SUM */
+  int frames; /* frames to add */
+  int added; /* frames added so far */
+  int size; /* bayer pixels of a frame */
+  u16 *acc; /* accumulator frame */
+};
+
+int stack_mode(char *name);
+struct stack *stack_create(int mode, int frames);
+void stack_reset(struct stack *s, int size);
+void stack_add(struct stack *s, int pos, const u8 *data, int len);
+void stack_result(struct stack *s, int pos, u8 *out, int len);
+void stack_destroy(struct stack *s);
+
+#endif
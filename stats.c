@@ -0,0 +1,213 @@
+/* stats.c
+**
+** Latency histograms of USB transfers, demosaic
+** and output, reported as one line of JSON
+**
+** License: GPL
+**
+*/
+#include "dcm300.h"
+#include "stats.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static char *stats_stage_name[STATS_STAGES] = {
+  "usb_read",
+  "usb_write",
+  "demosaic",
+  "output",
+  "bulk_gap",
+};
+
+struct stats *stats_create(int fd)
+{
+  struct stats *stats;
+
+  stats = calloc(1, sizeof(*stats));
+  if(stats == NULL)
+    return NULL;
+  stats->fd = fd;
+  stats->t0 = dcm300_ns();
+  return stats;
+}
+
+void stats_destroy(struct stats *stats)
+{
+  if(stats == NULL)
+    return;
+  if(stats->fd > STDERR_FILENO)
+    close(stats->fd);
+  free(stats);
+}
+
+/* values below STATS_SUB are exact, above them
+** bucket is exponent and top STATS_SUB_BITS of mantissa
+*/
+static int stats_bucket(u64 v)
+{
+  int e;
+
+  if(v < STATS_SUB)
+    return v;
+  e = 63 - __builtin_clzll(v);
+  return (e - STATS_SUB_BITS + 1) * STATS_SUB + ((v >> (e - STATS_SUB_BITS)) & (STATS_SUB - 1));
+}
+
+/* highest value that falls into bucket i */
+static u64 stats_bucket_value(int i)
+{
+  int e, shift;
+
+  if(i < STATS_SUB)
+    return i;
+  e = i / STATS_SUB + STATS_SUB_BITS - 1;
+  shift = e - STATS_SUB_BITS;
+  return (((u64) (STATS_SUB + i % STATS_SUB)) << shift) + (1ULL << shift) - 1;
+}
+
+void stats_add(struct stats *stats, int stage, u64 ns, int bytes)
+{
+  struct stats_histogram *h = &(stats->stage[stage]);
+
+  if(h->count == 0 || ns < h->min)
+    h->min = ns;
+  if(ns > h->max)
+    h->max = ns;
+  h->count++;
+  h->sum += ns;
+  if(bytes > 0)
+    h->bytes += bytes;
+  h->bucket[stats_bucket(ns)]++;
+}
+
+/* close the open frame */
+static void stats_frame_end(struct stats *stats)
+{
+  if(stats->frame_start && stats->frame_last > stats->frame_start)
+    stats->frame_ns += stats->frame_last - stats->frame_start;
+  stats->frame_start = 0;
+}
+
+/* bulk read that started at t_start has just completed */
+void stats_read(struct stats *stats, int want, int result, u64 t_start)
+{
+  u64 now = dcm300_ns();
+
+  stats_add(stats, STATS_USB_READ, now - t_start, result);
+  if(result < 0)
+    stats->failed_reads++;
+  else if(result < want)
+    stats->short_reads++;
+  if(stats->frame_start)
+  {
+    stats_add(stats, STATS_BULK_GAP, now - stats->frame_last, 0);
+    stats->frame_last = now;
+    if(result > 0)
+      stats->frame_bytes += result;
+  }
+}
+
+/* request written, this starts a new frame. A warm-up
+** frame is only counted, its reads stay out of the frame
+** bytes, rate and gaps
+*/
+void stats_write(struct stats *stats, int want, int result, u64 t_start)
+{
+  u64 now = dcm300_ns();
+
+  stats_add(stats, STATS_USB_WRITE, now - t_start, result);
+  if(result != want)
+    stats->failed_writes++;
+  stats_frame_end(stats);
+  if(stats->warmup)
+  {
+    stats->warmup_frames++;
+    return;
+  }
+  stats->frame_start = stats->frame_last = now;
+  stats->frames++;
+}
+
+/* smallest value that is not exceeded by fraction p of samples */
+u64 stats_percentile(struct stats_histogram *h, double p)
+{
+  u64 n = 0, want;
+  int i;
+
+  if(h->count == 0)
+    return 0;
+  want = p * h->count;
+  if(want < p * h->count)
+    want++;
+  if(want < 1)
+    want = 1;
+  for(i = 0; i < STATS_BUCKETS; i++)
+  {
+    n += h->bucket[i];
+    if(n >= want)
+      return stats_bucket_value(i) < h->max ? stats_bucket_value(i) : h->max;
+  }
+  return h->max;
+}
+
+/* bytes per second of ns nanoseconds */
+static double stats_rate(u64 bytes, u64 ns)
+{
+  return ns ? bytes * 1e9 / ns : 0;
+}
+
+/* write summary as a single line of JSON, times in microseconds */
+int stats_report(struct stats *stats)
+{
+  struct stats_histogram *h;
+  char json[4096];
+  int i, len;
+
+  stats_frame_end(stats);
+  len = 0;
+  if(stats->camera)
+    len = snprintf(json, sizeof(json), "{\"camera\":\"%s\",", stats->camera);
+  len += snprintf(json + len, sizeof(json) - len,
+    "%s\"elapsed_s\":%.6f,\"frames\":%d,\"warmup_frames\":%d,"
+    "\"usb\":{\"bytes\":%llu,\"bytes_per_s\":%.0f,\"max_gap_us\":%.1f,"
+    "\"short_reads\":%d,\"failed_reads\":%d,\"failed_writes\":%d},"
+    "\"stages\":{",
+    stats->camera ? "" : "{", (dcm300_ns() - stats->t0) * 1e-9, stats->frames, stats->warmup_frames,
+    stats->frame_bytes, stats_rate(stats->frame_bytes, stats->frame_ns),
+    stats->stage[STATS_BULK_GAP].max * 1e-3,
+    stats->short_reads, stats->failed_reads, stats->failed_writes);
+  for(i = 0; i < STATS_STAGES && len < (int) sizeof(json); i++)
+  {
+    h = &(stats->stage[i]);
+    len += snprintf(json + len, sizeof(json) - len,
+      "%s\"%s\":{\"count\":%llu,\"bytes\":%llu,\"bytes_per_s\":%.0f,"
+      "\"min_us\":%.1f,\"mean_us\":%.1f,\"p50_us\":%.1f,\"p90_us\":%.1f,"
+      "\"p99_us\":%.1f,\"p999_us\":%.1f,\"max_us\":%.1f}",
+      i ? "," : "", stats_stage_name[i], h->count, h->bytes, stats_rate(h->bytes, h->sum),
+      h->min * 1e-3, h->count ? h->sum * 1e-3 / h->count : 0,
+      stats_percentile(h, 0.5) * 1e-3, stats_percentile(h, 0.9) * 1e-3,
+      stats_percentile(h, 0.99) * 1e-3, stats_percentile(h, 0.999) * 1e-3,
+      h->max * 1e-3);
+  }
+  if(len < (int) sizeof(json))
+    len += snprintf(json + len, sizeof(json) - len, "}");
+  if(stats->pipeline && len < (int) sizeof(json))
+  {
+    const struct dcm300_pipeline_stats *p = stats->pipeline;
+
+    len += snprintf(json + len, sizeof(json) - len,
+      ",\"pipeline\":{\"chunks\":%llu,\"dropped_chunks\":%llu,\"dropped_bytes\":%llu,"
+      "\"queue_depth\":%d,\"queue_max\":%d,\"out_size\":%d,\"out_max\":%d,"
+      "\"backpressure_waits\":%llu,\"backpressure_us\":%.1f}",
+      p->chunks, p->dropped_chunks, p->dropped_bytes,
+      p->queue_depth, p->queue_max, p->out_size, p->out_max,
+      p->waits, p->wait_ns * 1e-3);
+  }
+  if(len < (int) sizeof(json))
+    len += snprintf(json + len, sizeof(json) - len, "}\n");
+  if(len >= (int) sizeof(json))
+    return -1;
+  return write(stats->fd, json, len) == len ? 0 : -1;
+}
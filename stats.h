@@ -0,0 +1,58 @@
+#ifndef STATS_H
+#define STATS_H
+#include "binarytype.h"
+#include "libdcm300.h"
+
+/* timing instrumentation of the capture path.
+** every transfer, demosaic and output write is timed
+** into a log-linear (HDR style) latency histogram:
+** each power of 2 is split into STATS_SUB linear
+** buckets, so any value is known within 1/STATS_SUB
+*/
+
+#define STATS_SUB_BITS 4
+#define STATS_SUB      (1 << STATS_SUB_BITS)
+#define STATS_BUCKETS  ((64 - STATS_SUB_BITS + 1) * STATS_SUB)
+
+/* timed stages */
+#define STATS_USB_READ  0
+#define STATS_USB_WRITE 1
+#define STATS_DEMOSAIC  2 /* bayer to RGB, without output writes */
+#define STATS_OUTPUT    3
+#define STATS_BULK_GAP  4 /* between completions of consecutive reads of a frame */
+#define STATS_STAGES    5
+
+struct stats_histogram {
+  u64 count;
+  u64 bytes; /* bytes processed by the stage */
+  u64 sum, min, max; /* ns */
+  u32 bucket[STATS_BUCKETS];
+};
+
+struct stats {
+  int fd; /* JSON reports are written here */
+  const char *camera; /* port id in the report of --all, or NULL */
+  u64 t0; /* creation time */
+  u64 frame_start; /* time the last request was written, 0-no frame open */
+  u64 frame_last; /* completion of the last read of that frame */
+  u64 frame_ns; /* request to last read, summed over frames */
+  u64 frame_bytes; /* bytes read during these frames */
+  int frames; /* snapshots, stacked frames count one each */
+  int warmup; /* 1-frame being read is a warm-up or metering frame */
+  int warmup_frames; /* counted apart, not in frames and usb totals */
+  int short_reads; /* fewer bytes than requested */
+  int failed_reads;
+  int failed_writes;
+  struct stats_histogram stage[STATS_STAGES];
+  const struct dcm300_pipeline_stats *pipeline; /* counters of the session or NULL */
+};
+
+struct stats *stats_create(int fd);
+void stats_destroy(struct stats *stats);
+void stats_add(struct stats *stats, int stage, u64 ns, int bytes);
+void stats_read(struct stats *stats, int want, int result, u64 t_start);
+void stats_write(struct stats *stats, int want, int result, u64 t_start);
+u64 stats_percentile(struct stats_histogram *h, double p);
+int stats_report(struct stats *stats);
+
+#endif
@@ -8,16 +8,7 @@
 #      </action>
 #    </keybind>
 
-~/bin/dcm300 \
-| convert \
-pnm:- \
--background white \
--pointsize 70 \
--font DejaVu-Sans-Mono \
-label:'0▕▄█▄█▄█▄█▄█ 2' \
--gravity center \
--append \
-/tmp/microscope.jpg
+~/bin/dcm300 -S /tmp/dcm300.sock -O ':843:2' -o /tmp/microscope.jpg
 
 mv /tmp/microscope.jpg ~/Pictures/microscope.jpg
 eog ~/Pictures/microscope.jpg
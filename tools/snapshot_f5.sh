@@ -8,19 +8,9 @@
 #      </action>
 #    </keybind>
 
-~/bin/dcm300 \
-| convert \
-pnm:- \
--background white \
--font DejaVu-Sans-Mono \
--pointsize 55 \
-label:'4x 0▕▄█▄█▄█▄█▄█ 1 mm' \
--gravity center \
--append \
-/tmp/microscope.jpg
+~/bin/dcm300 -S /tmp/dcm300.sock -O '4x' -o /tmp/microscope.jpg
 
 mv /tmp/microscope.jpg ~/Pictures/microscope.jpg
 eog ~/Pictures/microscope.jpg
 
-# -pointsize 57 \
-# label:'4x 0▕▄█▄█▄█▄█▄█ 2 mm' \
+# -O '4x:686:2 mm'
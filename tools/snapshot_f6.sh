@@ -8,16 +8,7 @@
 #      </action>
 #    </keybind>
 
-~/bin/dcm300 \
-| convert \
-pnm:- \
--background white \
--pointsize 72 \
--font DejaVu-Sans-Mono \
-label:'10x 0▕▄█▄█▄█▄█▄█ 500 µm' \
--gravity center \
--append \
-/tmp/microscope.jpg
+~/bin/dcm300 -S /tmp/dcm300.sock -O '10x' -o /tmp/microscope.jpg
 
 mv /tmp/microscope.jpg ~/Pictures/microscope.jpg
 eog ~/Pictures/microscope.jpg
@@ -8,16 +8,7 @@
 #      </action>
 #    </keybind>
 
-~/bin/dcm300 \
-| convert \
-pnm:- \
--background white \
--pointsize 56 \
--font DejaVu-Sans-Mono \
-label:'40x 0▕▄█▄█▄█▄█▄█ 100 µm' \
--gravity center \
--append \
-/tmp/microscope.jpg
+~/bin/dcm300 -S /tmp/dcm300.sock -O '40x' -o /tmp/microscope.jpg
 
 mv /tmp/microscope.jpg ~/Pictures/microscope.jpg
 eog ~/Pictures/microscope.jpg
@@ -0,0 +1,311 @@
+/* trace.c
+**
+** Record and replay of USB bulk transfers.
+** Recording stores every request and response
+** with its size and timestamps, replay delivers
+** the same data at the same pace as the camera did
+**
+** License: GPL
+**
+*/
+#include "dcm300.h"
+#include "trace.h"
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <time.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+
+#define TRACE_TIMEOUT_MS 2000 /* same as bulk read timeout on hardware */
+
+static int trace_full_read(int fd, void *buffer, int bytes)
+{
+  int n, done = 0;
+
+  while(done < bytes)
+  {
+    n = read(fd, (u8 *) buffer + done, bytes - done);
+    if(n < 0 && errno == EINTR)
+      continue;
+    if(n <= 0)
+      break;
+    done += n;
+  }
+  return done;
+}
+
+static int trace_full_write(int fd, void *buffer, int bytes)
+{
+  int n, done = 0;
+
+  while(done < bytes)
+  {
+    n = write(fd, (u8 *) buffer + done, bytes - done);
+    if(n < 0 && errno == EINTR)
+      continue;
+    if(n <= 0)
+      return -1;
+    done += n;
+  }
+  return 0;
+}
+
+/* 1 if file is a trace */
+int trace_probe(char *name)
+{
+  struct trace_header h;
+  int fd, n;
+
+  fd = open(name, O_RDONLY);
+  if(fd < 0)
+    return 0;
+  n = trace_full_read(fd, &h, sizeof(h));
+  close(fd);
+  return n == sizeof(h) && memcmp(h.magic, TRACE_MAGIC, sizeof(h.magic)) == 0;
+}
+
+/* start recording to a new trace file */
+struct trace *trace_create(char *name)
+{
+  struct trace_header h;
+  struct trace *trace;
+
+  trace = calloc(1, sizeof(*trace));
+  if(trace == NULL)
+    return NULL;
+  trace->fd = open(name, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if(trace->fd < 0)
+  {
+    perror("trace_create: Unable to create trace file");
+    free(trace);
+    return NULL;
+  }
+  memset(&h, 0, sizeof(h));
+  memcpy(h.magic, TRACE_MAGIC, sizeof(h.magic));
+  h.version = TRACE_VERSION;
+  if(trace_full_write(trace->fd, &h, sizeof(h)))
+  {
+    perror("trace_create: write");
+    trace_close(trace);
+    return NULL;
+  }
+  trace->t0 = dcm300_ns();
+  return trace;
+}
+
+/* open trace file for replay */
+struct trace *trace_open(char *name)
+{
+  struct trace_header h;
+  struct trace *trace;
+
+  trace = calloc(1, sizeof(*trace));
+  if(trace == NULL)
+    return NULL;
+  trace->replay = 1;
+  trace->fd = open(name, O_RDONLY);
+  if(trace->fd < 0)
+  {
+    perror("trace_open: Unable to open trace file");
+    free(trace);
+    return NULL;
+  }
+  if(trace_full_read(trace->fd, &h, sizeof(h)) != sizeof(h)
+  || memcmp(h.magic, TRACE_MAGIC, sizeof(h.magic)) != 0
+  || h.version != TRACE_VERSION)
+  {
+    fprintf(stderr, "trace_open: %s is not a version %d trace\n", name, TRACE_VERSION);
+    trace_close(trace);
+    return NULL;
+  }
+  trace->first = sizeof(h);
+  trace->base = dcm300_ns();
+  return trace;
+}
+
+void trace_close(struct trace *trace)
+{
+  if(trace == NULL)
+    return;
+  if(trace->fd >= 0)
+    close(trace->fd);
+  free(trace);
+}
+
+/* append one transfer, t_start is dcm300_ns() when it was issued */
+int trace_add(struct trace *trace, int type, int want, int result, u64 t_start, u8 *data)
+{
+  struct trace_record r;
+
+  memset(&r, 0, sizeof(r));
+  r.type = type;
+  r.want = want;
+  r.result = result;
+  r.t_start = t_start - trace->t0;
+  r.t_end = dcm300_ns() - trace->t0;
+  if(trace_full_write(trace->fd, &r, sizeof(r)))
+    return -1;
+  if(result > 0 && trace_full_write(trace->fd, data, result))
+    return -1;
+  return 0;
+}
+
+/* header of the next record, NULL at end of trace */
+static struct trace_record *trace_peek(struct trace *trace)
+{
+  if(!trace->have_next)
+    trace->have_next =
+      trace_full_read(trace->fd, &(trace->next), sizeof(trace->next)) == sizeof(trace->next);
+  return trace->have_next ? &(trace->next) : NULL;
+}
+
+/* skip data of the record returned by trace_peek() */
+static void trace_skip(struct trace *trace, int bytes)
+{
+  if(bytes > 0)
+    lseek(trace->fd, bytes, SEEK_CUR);
+  trace->have_next = 0;
+}
+
+static void trace_sleep(u64 ns)
+{
+  struct timespec t;
+
+  t.tv_sec = ns / 1000000000ULL;
+  t.tv_nsec = ns % 1000000000ULL;
+  while(nanosleep(&t, &t) < 0 && errno == EINTR);
+}
+
+/* sleep until recorded time t, relative to the last write */
+static void trace_wait(struct trace *trace, u64 t)
+{
+  u64 now = dcm300_ns();
+  u64 due = trace->base + (t > trace->mark ? t - trace->mark : 0);
+
+  if(due > now)
+    trace_sleep(due - now);
+}
+
+/*
+** replay a request. Responses of the previous request
+** that were not read are dropped. At the end of the
+** trace it starts over from the first request, so
+** one recorded frame can be replayed many times
+*/
+int trace_write(struct trace *trace, u8 *buffer, int bytes)
+{
+  struct trace_record *r;
+  u8 recorded[256];
+  int result, rewound = 0;
+
+  for(;;)
+  {
+    r = trace_peek(trace);
+    if(r && r->type == TRACE_WRITE)
+      break;
+    if(r)
+    {
+      trace_skip(trace, r->result);
+      continue;
+    }
+    if(rewound++)
+    {
+      fprintf(stderr, "trace_write: no request in trace\n");
+      return -EIO;
+    }
+    lseek(trace->fd, trace->first, SEEK_SET);
+    trace->have_next = 0;
+  }
+
+  result = r->result;
+  if(verbose && result == bytes && result <= (int) sizeof(recorded))
+  {
+    if(trace_full_read(trace->fd, recorded, result) == result
+    && memcmp(recorded, buffer, bytes) != 0)
+      fprintf(stderr, "trace_write: request differs from the recorded one\n");
+    trace_skip(trace, 0);
+  }
+  else
+    trace_skip(trace, result);
+
+  /* the request takes as long as it did on the camera */
+  trace->base = dcm300_ns();
+  trace->mark = r->t_start;
+  trace_wait(trace, r->t_end);
+  trace->base = dcm300_ns();
+  trace->mark = r->t_end;
+  return result;
+}
+
+/*
+** replay a response at the recorded time after its request.
+** When the trace has no more responses for this request
+** the read times out, as it would on the camera
+*/
+int trace_read(struct trace *trace, u8 *buffer, int bytes)
+{
+  struct trace_record *r;
+  int result, n;
+
+  r = trace_peek(trace);
+  if(r == NULL || r->type != TRACE_READ)
+  {
+    trace_sleep(TRACE_TIMEOUT_MS * 1000000ULL);
+    return -ETIMEDOUT;
+  }
+  trace_wait(trace, r->t_end);
+  result = r->result;
+  if(result > 0)
+  {
+    n = result < bytes ? result : bytes;
+    if(trace_full_read(trace->fd, buffer, n) != n)
+      n = -EIO;
+    trace_skip(trace, result - n);
+    return n;
+  }
+  trace_skip(trace, 0);
+  return result;
+}
+
+/* print records of a trace with gaps between completions */
+int trace_dump(char *name)
+{
+  struct trace *trace;
+  struct trace_record *r;
+  u64 last = 0, gap, gap_max = 0;
+  int records = 0, reads = 0, errors = 0;
+  double bytes = 0;
+
+  trace = trace_open(name);
+  if(trace == NULL)
+    return -1;
+  printf("%12s %c %7s %7s %10s %10s\n", "t ms", 'T', "want", "result", "took ms", "gap ms");
+  while((r = trace_peek(trace)) != NULL)
+  {
+    gap = records ? r->t_end - last : 0;
+    printf("%12.3f %c %7d %7d %10.3f %10.3f\n",
+      r->t_end * 1e-6, r->type, r->want, r->result,
+      (r->t_end - r->t_start) * 1e-6, gap * 1e-6);
+    if(r->type == TRACE_READ)
+    {
+      reads++;
+      if(gap > gap_max)
+        gap_max = gap;
+    }
+    if(r->result < 0)
+      errors++;
+    else
+      bytes += r->result;
+    last = r->t_end;
+    records++;
+    trace_skip(trace, r->result);
+  }
+  printf("records %d reads %d errors %d bytes %.0f max read gap %.3f ms\n",
+    records, reads, errors, bytes, gap_max * 1e-6);
+  trace_close(trace);
+  return 0;
+}
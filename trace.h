@@ -0,0 +1,56 @@
+#ifndef TRACE_H
+#define TRACE_H
+#include <sys/types.h>
+#include "binarytype.h"
+
+/* USB transfer trace, recorded on real hardware and
+** replayed with the same sizes and timing without a camera.
+**
+** file: trace_header, then for every bulk transfer
+** a trace_record followed by max(result,0) data bytes.
+** Integers are in host byte order.
+*/
+
+#define TRACE_MAGIC   "DCM300TR"
+#define TRACE_VERSION 1
+
+#define TRACE_WRITE 'W' /* bulk out, request packet */
+#define TRACE_READ  'R' /* bulk in, header, image chunk or footer */
+
+struct trace_header {
+  char magic[8]; /* TRACE_MAGIC */
+  u32 version; /* TRACE_VERSION */
+  u32 reserved;
+};
+
+struct trace_record {
+  u8 type; /* TRACE_WRITE or TRACE_READ */
+  u8 reserved[3];
+  s32 want; /* bytes requested */
+  s32 result; /* bytes transferred or negative error */
+  u32 reserved2;
+  u64 t_start; /* ns from start of recording when transfer was issued */
+  u64 t_end; /* ns from start of recording when it completed */
+};
+
+struct trace {
+  int fd;
+  int replay; /* 0-recording 1-replaying */
+  u64 t0; /* recording: start time */
+  u64 base; /* replaying: time when last write completed */
+  u64 mark; /* replaying: recorded t_end of that write */
+  off_t first; /* file offset of the first record */
+  int have_next; /* next record header is already read */
+  struct trace_record next;
+};
+
+int trace_probe(char *name);
+struct trace *trace_create(char *name);
+struct trace *trace_open(char *name);
+void trace_close(struct trace *trace);
+int trace_add(struct trace *trace, int type, int want, int result, u64 t_start, u8 *data);
+int trace_write(struct trace *trace, u8 *buffer, int bytes);
+int trace_read(struct trace *trace, u8 *buffer, int bytes);
+int trace_dump(char *name);
+
+#endif
@@ -0,0 +1,274 @@
+/* usbfs.c
+**
+** Direct linux usbfs access to DCM300
+** with asynchronous bulk URB queue
+**
+** License: GPL
+**
+*/
+#include "dcm300.h"
+#include "usbfs.h"
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/ioctl.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+
+/* open usbfs device node e.g. /dev/bus/usb/003/012
+** and claim interface 0. Reading the node gives the
+** device descriptor, a node that is not a DCM300 is refused
+*/
+int usbfs_open(struct dcm300 *dcm300, char *path)
+{
+  unsigned int interface = 0;
+  u8 descriptor[18];
+  int fd;
+
+  fd = open(path, O_RDWR);
+  if(fd < 0)
+  {
+    perror("usbfs_open: Unable to open usb device node");
+    return -1;
+  }
+  if(read(fd, descriptor, sizeof(descriptor)) != sizeof(descriptor)
+  || (descriptor[8] | descriptor[9] << 8) != DCM300_VENDOR
+  || (descriptor[10] | descriptor[11] << 8) != DCM300_PRODUCT)
+  {
+    fprintf(stderr, "usbfs_open: %s is not a DCM300\n", path);
+    close(fd);
+    return -1;
+  }
+  if(ioctl(fd, USBDEVFS_CLAIMINTERFACE, &interface) < 0)
+  {
+    perror("usbfs_open: claim interface failed");
+    close(fd);
+    return -1;
+  }
+  dcm300->usbfs = fd;
+  return 0;
+}
+
+int usbfs_close(struct dcm300 *dcm300)
+{
+  unsigned int interface = 0;
+  struct usbfs_queue *q = dcm300->queue;
+
+  if(q)
+  {
+    usbfs_queue_cancel(dcm300);
+    free(q->buffer);
+    free(q->urb);
+    free(q);
+    dcm300->queue = NULL;
+  }
+  if(dcm300->usbfs >= 0)
+  {
+    ioctl(dcm300->usbfs, USBDEVFS_RELEASEINTERFACE, &interface);
+    close(dcm300->usbfs);
+    dcm300->usbfs = -1;
+  }
+  return 0;
+}
+
+int usbfs_bulk_write(struct dcm300 *dcm300, u8 *buffer, int bytes, int timeout)
+{
+  struct usbdevfs_bulktransfer bulk;
+
+  bulk.ep = USBFS_EP_REQUEST;
+  bulk.len = bytes;
+  bulk.timeout = timeout;
+  bulk.data = buffer;
+  return ioctl(dcm300->usbfs, USBDEVFS_BULK, &bulk);
+}
+
+/* synchronous read of the image endpoint */
+int usbfs_bulk_read(struct dcm300 *dcm300, u8 *buffer, int bytes, int timeout)
+{
+  struct usbdevfs_bulktransfer bulk;
+
+  bulk.ep = USBFS_EP_IMAGE;
+  bulk.len = bytes;
+  bulk.timeout = timeout;
+  bulk.data = buffer;
+  return ioctl(dcm300->usbfs, USBDEVFS_BULK, &bulk);
+}
+
+/* allocate depth URBs of size bytes each */
+int usbfs_queue_create(struct dcm300 *dcm300, int depth, int size)
+{
+  struct usbfs_queue *q;
+
+  q = calloc(1, sizeof(*q));
+  if(q == NULL)
+    return -1;
+  q->depth = depth;
+  q->size = size;
+  q->stage = 3;
+  q->buffer = malloc(depth * size);
+  q->urb = calloc(depth, sizeof(*q->urb));
+  if(q->buffer == NULL || q->urb == NULL)
+  {
+    free(q->buffer);
+    free(q->urb);
+    free(q);
+    return -1;
+  }
+  dcm300->queue = q;
+  return 0;
+}
+
+/* queue next planned transfer of the frame if there's a free URB
+** returns 1 if URB was submitted, 0 if nothing to submit, -1 on error
+*/
+static int usbfs_queue_submit(struct dcm300 *dcm300)
+{
+  struct usbfs_queue *q = dcm300->queue;
+  struct usbfs_urb *u;
+  int slot, len;
+
+  if(q->count >= q->depth || q->stage > 2)
+    return 0;
+
+  switch(q->stage)
+  {
+    case 0:
+      len = 64;
+      q->stage = q->image_left > 0 ? 1 : 2;
+      break;
+    case 1:
+      len = q->image_left > q->size ? q->size : q->image_left;
+      q->image_left -= len;
+      if(q->image_left <= 0)
+        q->stage = 2;
+      break;
+    default:
+      /* at some sizes the camera merges the last 256 image
+      ** bytes with the footer, a 256 byte URB would overflow.
+      ** Reads take only the bytes asked for */
+      len = q->size;
+      q->stage = 3;
+      break;
+  }
+
+  slot = (q->head + q->count) % q->depth;
+  u = &(q->urb[slot]);
+  memset(&(u->urb), 0, sizeof(u->urb));
+  u->urb.type = USBDEVFS_URB_TYPE_BULK;
+  u->urb.endpoint = USBFS_EP_IMAGE;
+  u->urb.buffer = q->buffer + slot * q->size;
+  u->urb.buffer_length = len;
+  u->urb.usercontext = u;
+  if(ioctl(dcm300->usbfs, USBDEVFS_SUBMITURB, &(u->urb)) < 0)
+  {
+    perror("usbfs: submit urb failed");
+    q->stage = 3;
+    return -1;
+  }
+  u->state = URB_SUBMITTED;
+  q->count++;
+  return 1;
+}
+
+/* collect all completed URBs, wait up to timeout ms for at least one */
+static int usbfs_queue_reap(struct dcm300 *dcm300, int timeout)
+{
+  struct usbdevfs_urb *urb;
+  struct usbfs_urb *u;
+  struct pollfd pfd;
+  int reaped = 0;
+
+  for(;;)
+  {
+    if(ioctl(dcm300->usbfs, USBDEVFS_REAPURBNDELAY, &urb) == 0)
+    {
+      u = (struct usbfs_urb *) urb->usercontext;
+      u->state = URB_DONE;
+      reaped++;
+      continue;
+    }
+    if(errno != EAGAIN)
+      return -1;
+    if(reaped > 0)
+      return reaped;
+    pfd.fd = dcm300->usbfs;
+    pfd.events = POLLOUT;
+    pfd.revents = 0;
+    if(poll(&pfd, 1, timeout) <= 0)
+      return -1;
+  }
+}
+
+/* start queueing the transfers of a new frame,
+** called before the request is sent so that
+** URBs are already waiting when the camera starts streaming
+*/
+int usbfs_queue_frame(struct dcm300 *dcm300, int image_bytes)
+{
+  struct usbfs_queue *q = dcm300->queue;
+
+  usbfs_queue_cancel(dcm300);
+  q->stage = 0;
+  q->image_left = image_bytes;
+  while(usbfs_queue_submit(dcm300) > 0);
+  return q->count > 0 ? 0 : -1;
+}
+
+/* deliver oldest transfer of the frame and
+** immediately reuse its URB for the next planned one
+** returns number of bytes or negative error like usb_bulk_read()
+*/
+int usbfs_queue_read(struct dcm300 *dcm300, u8 *buffer, int bytes, int timeout)
+{
+  struct usbfs_queue *q = dcm300->queue;
+  struct usbfs_urb *u;
+  int len;
+
+  if(q->count == 0)
+    return -ENODATA;
+  u = &(q->urb[q->head]);
+  while(u->state != URB_DONE)
+    if(usbfs_queue_reap(dcm300, timeout) < 0)
+      return -ETIMEDOUT;
+
+  len = u->urb.status < 0 ? u->urb.status : u->urb.actual_length;
+  if(len > bytes)
+    len = bytes;
+  if(len > 0)
+    memcpy(buffer, u->urb.buffer, len);
+  u->state = URB_IDLE;
+  q->head = (q->head + 1) % q->depth;
+  q->count--;
+  usbfs_queue_submit(dcm300);
+  return len;
+}
+
+/* discard URBs left over from a short or failed frame */
+int usbfs_queue_cancel(struct dcm300 *dcm300)
+{
+  struct usbfs_queue *q = dcm300->queue;
+  struct usbdevfs_urb *urb;
+  int i;
+
+  for(i = 0; i < q->count; i++)
+  {
+    struct usbfs_urb *u = &(q->urb[(q->head + i) % q->depth]);
+    if(u->state == URB_SUBMITTED)
+    {
+      /* discard fails if URB has just completed, reap it anyway */
+      ioctl(dcm300->usbfs, USBDEVFS_DISCARDURB, &(u->urb));
+      while(u->state == URB_SUBMITTED
+         && ioctl(dcm300->usbfs, USBDEVFS_REAPURB, &urb) == 0)
+        ((struct usbfs_urb *) urb->usercontext)->state = URB_DONE;
+    }
+    u->state = URB_IDLE;
+  }
+  q->head = 0;
+  q->count = 0;
+  q->stage = 3;
+  return 0;
+}
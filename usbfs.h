@@ -0,0 +1,52 @@
+#ifndef USBFS_H
+#define USBFS_H
+#include <linux/usbdevice_fs.h>
+#include "binarytype.h"
+
+/* linux usbfs transport for dcm300
+** keeps several bulk URBs queued on the image endpoint
+** so the host controller never idles between our reads
+*/
+
+#define USBFS_EP_REQUEST 0x02 /* bulk out, request packets */
+#define USBFS_EP_IMAGE   0x86 /* bulk in, image stream */
+#define USBFS_PACKET     512  /* high speed bulk packet size */
+
+#define URB_IDLE      0
+#define URB_SUBMITTED 1
+#define URB_DONE      2
+
+struct usbfs_urb {
+  struct usbdevfs_urb urb;
+  int state; /* URB_IDLE, URB_SUBMITTED or URB_DONE */
+};
+
+/* one frame is transferred as 64 byte header,
+** image in bulk sized chunks and 256 byte footer
+** (bulk sized URB, it may carry the image tail too).
+** URBs are submitted in that order and delivered
+** to the reader in the same order
+*/
+struct usbfs_queue {
+  int depth; /* number of URBs kept queued */
+  int size; /* bytes per image chunk URB */
+  int head; /* oldest queued URB, next to be delivered */
+  int count; /* URBs queued or completed but not delivered */
+  int stage; /* 0-header 1-image 2-footer 3-frame fully queued */
+  int image_left; /* image bytes not yet queued */
+  u8 *buffer; /* depth*size bytes of URB buffers */
+  struct usbfs_urb *urb;
+};
+
+struct dcm300;
+
+int usbfs_open(struct dcm300 *dcm300, char *path);
+int usbfs_close(struct dcm300 *dcm300);
+int usbfs_bulk_write(struct dcm300 *dcm300, u8 *buffer, int bytes, int timeout);
+int usbfs_bulk_read(struct dcm300 *dcm300, u8 *buffer, int bytes, int timeout);
+int usbfs_queue_create(struct dcm300 *dcm300, int depth, int size);
+int usbfs_queue_frame(struct dcm300 *dcm300, int image_bytes);
+int usbfs_queue_read(struct dcm300 *dcm300, u8 *buffer, int bytes, int timeout);
+int usbfs_queue_cancel(struct dcm300 *dcm300);
+
+#endif